@@ -1,9 +1,24 @@
 #include "to_newick.hpp"
 
+#include <algorithm>
+#include <charconv>
+#include <ostream>
+
+#include "../utils/parallel.hpp"
+
 AVLTree makeTree(const PhyloVec &v) {
+    AVLTree avl_tree;
+
+    makeTree(v, avl_tree);
+
+    return avl_tree;
+}
+
+void makeTree(const PhyloVec &v, AVLTree &avl_tree) {
     const size_t k = v.size();
 
-    AVLTree avl_tree;
+    avl_tree.clear();
+    avl_tree.reserve(k);
 
     avl_tree.insert(0, {0, 1});
 
@@ -38,15 +53,71 @@ AVLTree makeTree(const PhyloVec &v) {
             avl_tree.insert(index + 1, {value[0], nextLeaf});
         }
     }
+}
 
-    return avl_tree;
+void getPairsFlat(const PhyloVec &v, Pairs &pairs) {
+    const size_t k = v.size();
+
+    pairs.clear();
+    pairs.reserve(k);
+
+    pairs.push_back({0, 1});
+
+    for (size_t i = 1; i < k; ++i) {
+        unsigned int nextLeaf = i + 1;
+
+        if (v[i] <= i) {
+            pairs.insert(pairs.begin(), {v[i], nextLeaf});
+        } else {
+            unsigned int index = v[i] - nextLeaf;
+            pairs.insert(pairs.begin() + index + 1, {pairs[index][0], nextLeaf});
+        }
+    }
 }
 
 Pairs getPairs(const PhyloVec &v) {
+    if (v.size() + 1 < SMALL_TREE_LEAVES) {
+        Pairs pairs;
+        getPairsFlat(v, pairs);
+        return pairs;
+    }
+
     AVLTree tree = makeTree(v);
     return tree.getPairs();
 }
 
+void getPairs(const PhyloVec &v, AVLTree &tree, Pairs &pairs) {
+    if (v.size() + 1 < SMALL_TREE_LEAVES) {
+        getPairsFlat(v, pairs);
+        return;
+    }
+
+    makeTree(v, tree);
+    tree.getPairs(pairs);
+}
+
+unsigned int getChildren(const Pairs &pairs, unsigned int numLeaves, Pairs &children,
+                         std::vector<unsigned int> &top) {
+    top.resize(numLeaves);
+    for (unsigned int i = 0; i < numLeaves; ++i) {
+        top[i] = i;
+    }
+
+    children.resize(numLeaves - 1);
+    for (unsigned int i = 0; i + 1 < numLeaves; ++i) {
+        auto &[c1, c2] = pairs[i];
+        children[i] = {top[c1], top[c2]};
+        top[c1] = numLeaves + i;
+    }
+
+    return top[0];
+}
+
+unsigned int getChildren(const Pairs &pairs, unsigned int numLeaves, Pairs &children) {
+    std::vector<unsigned int> top;
+    return getChildren(pairs, numLeaves, children, top);
+}
+
 [[deprecated("getAncestry is no longer used in toNewick, and is left for legacy reasons")]] Ancestry
 getAncestry(const PhyloVec &v) {
     const size_t k = v.size();
@@ -77,30 +148,212 @@ getAncestry(const PhyloVec &v) {
     return ancestry;
 }
 
-std::string buildNewick(const Pairs &pairs, bool withInternals) {
-    const unsigned int numLeaves = pairs.size() + 1;
+namespace {
 
-    std::vector<std::string> cache;
-    cache.reserve(numLeaves);
-    for (size_t i = 0; i < numLeaves; ++i) {
-        cache.push_back(std::to_string(i));
+// Total number of digits of all integers in [lo, hi)
+size_t sumDigits(size_t lo, size_t hi) {
+    size_t total = 0;
+    size_t digits = 1;
+    size_t start = 0;
+    size_t end = 10;
+    while (start < hi) {
+        size_t a = std::max(lo, start);
+        size_t b = std::min(hi, end);
+        if (a < b) {
+            total += (b - a) * digits;
+        }
+        start = end;
+        end *= 10;
+        ++digits;
     }
+    return total;
+}
 
-    for (size_t i = 0; i < pairs.size(); ++i) {
-        auto &[c1, c2] = pairs[i];
+}  // namespace
+
+size_t getNewickLength(size_t numLeaves, bool withInternals) {
+    const size_t numPairs = numLeaves - 1;
+
+    // Leaf labels + "(", ",", ")" per internal node + ";"
+    size_t length = sumDigits(0, numLeaves) + 3 * numPairs + 1;
+
+    if (withInternals) {
+        length += sumDigits(numLeaves, numLeaves + numPairs);
+    }
+
+    return length;
+}
+
+namespace {
+
+// Writes chars directly into a buffer of known size
+struct BufferWriter {
+    char *ptr;
 
-        cache[c1] = "(" + std::move(cache[c1]) + "," + std::move(cache[c2]) + ")";
+    void put(char c) { *ptr++ = c; }
 
-        if (withInternals) {
-            std::string next_parent = std::to_string(numLeaves + i);
-            cache[c1] += next_parent;
+    void putLabel(unsigned int label) { ptr = std::to_chars(ptr, ptr + 10, label).ptr; }
+};
+
+// Writes chars into a fixed-size chunk which is handed to a sink when full
+struct ChunkWriter {
+    const NewickSink &sink;
+    std::vector<char> chunk;
+    size_t size = 0;
+
+    ChunkWriter(const NewickSink &sink, size_t chunkSize)
+        : sink(sink), chunk(std::max<size_t>(chunkSize, 16)) {}
+
+    void flush() {
+        if (size > 0) {
+            sink(std::string_view(chunk.data(), size));
+            size = 0;
         }
     }
 
-    return cache[0] + ";";
+    void put(char c) {
+        if (size == chunk.size()) {
+            flush();
+        }
+        chunk[size++] = c;
+    }
+
+    void putLabel(unsigned int label) {
+        // An unsigned int has at most 10 digits
+        if (size + 10 > chunk.size()) {
+            flush();
+        }
+        char *start = chunk.data() + size;
+        size += std::to_chars(start, start + 10, label).ptr - start;
+    }
+};
+
+// Marker for the closing bracket of an internal node on the writing stack
+const unsigned int CLOSE_BIT = 1u << 31;
+// Marker for a comma between two children on the writing stack
+const unsigned int COMMA = ~0u;
+
+// Scratch space: children of the internal nodes, subtree tops and writing stack
+// (those of a ConversionWorkspace, or vectors local to one call)
+template <typename Writer>
+void emitNewick(const Pairs &pairs, bool withInternals, Writer &writer, Pairs &children,
+                std::vector<unsigned int> &top, std::vector<unsigned int> &stack) {
+    const unsigned int numPairs = pairs.size();
+    const unsigned int numLeaves = numPairs + 1;
+
+    // Children of internal node numLeaves + i
+    const unsigned int root = getChildren(pairs, numLeaves, children, top);
+
+    // Pre-order traversal: open a node, then write its children and close it
+    stack.assign(1, root);
+
+    while (!stack.empty()) {
+        unsigned int node = stack.back();
+        stack.pop_back();
+
+        if (node == COMMA) {
+            writer.put(',');
+        } else if (node & CLOSE_BIT) {
+            writer.put(')');
+            if (withInternals) {
+                writer.putLabel(node & ~CLOSE_BIT);
+            }
+        } else if (node < numLeaves) {
+            writer.putLabel(node);
+        } else {
+            auto &[left, right] = children[node - numLeaves];
+            writer.put('(');
+            stack.push_back(node | CLOSE_BIT);
+            stack.push_back(right);
+            stack.push_back(COMMA);
+            stack.push_back(left);
+        }
+    }
+
+    writer.put(';');
+}
+
+}  // namespace
+
+size_t buildNewick(const Pairs &pairs, char *buffer, bool withInternals) {
+    Pairs children;
+    std::vector<unsigned int> top, stack;
+    BufferWriter writer{buffer};
+    emitNewick(pairs, withInternals, writer, children, top, stack);
+    return writer.ptr - buffer;
+}
+
+void buildNewick(const Pairs &pairs, std::string &newick, bool withInternals) {
+    newick.resize(getNewickLength(pairs.size() + 1, withInternals));
+    buildNewick(pairs, newick.data(), withInternals);
+}
+
+void buildNewick(const Pairs &pairs, std::string &newick, ConversionWorkspace &ws,
+                 bool withInternals) {
+    newick.resize(getNewickLength(pairs.size() + 1, withInternals));
+    BufferWriter writer{newick.data()};
+    emitNewick(pairs, withInternals, writer, ws.children, ws.subtreeTops, ws.writeStack);
+}
+
+std::string buildNewick(const Pairs &pairs, bool withInternals) {
+    std::string newick;
+    buildNewick(pairs, newick, withInternals);
+    return newick;
 }
 
 std::string toNewick(const PhyloVec &v, bool withInternals) {
     Pairs pairs = getPairs(v);
     return buildNewick(pairs, withInternals);
-}
\ No newline at end of file
+}
+
+void toNewick(const PhyloVec &v, std::string &newick, bool withInternals) {
+    ConversionWorkspace ws;
+    toNewick(v, newick, ws, withInternals);
+}
+
+void toNewick(const PhyloVec &v, std::string &newick, ConversionWorkspace &ws,
+              bool withInternals) {
+    getPairs(v, ws.tree, ws.pairs);
+    buildNewick(ws.pairs, newick, ws, withInternals);
+}
+
+std::vector<std::string> toNewickBatch(const std::vector<PhyloVec> &vs, bool withInternals,
+                                       unsigned int numThreads) {
+    std::vector<std::string> newicks(vs.size());
+
+    numThreads = getNumThreads(numThreads);
+
+    // Per-thread scratch space
+    std::vector<ConversionWorkspace> workspaces(numThreads);
+
+    parallelFor(vs.size(), numThreads, [&](size_t i, unsigned int t) {
+        toNewick(vs[i], newicks[i], workspaces[t], withInternals);
+    });
+
+    return newicks;
+}
+
+void streamNewick(const Pairs &pairs, const NewickSink &sink, bool withInternals,
+                  size_t chunkSize) {
+    Pairs children;
+    std::vector<unsigned int> top, stack;
+    ChunkWriter writer(sink, chunkSize);
+    emitNewick(pairs, withInternals, writer, children, top, stack);
+    writer.flush();
+}
+
+void streamNewick(const Pairs &pairs, std::ostream &os, bool withInternals) {
+    streamNewick(
+        pairs, [&os](std::string_view chunk) { os.write(chunk.data(), chunk.size()); },
+        withInternals);
+}
+
+void toNewickStream(const PhyloVec &v, const NewickSink &sink, bool withInternals) {
+    Pairs pairs = getPairs(v);
+    streamNewick(pairs, sink, withInternals);
+}
+
+void toNewickStream(const PhyloVec &v, std::ostream &os, bool withInternals) {
+    Pairs pairs = getPairs(v);
+    streamNewick(pairs, os, withInternals);
+}
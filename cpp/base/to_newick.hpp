@@ -6,13 +6,70 @@
  * @brief Vector-to-Newick conversion functions
  */
 
+#include <functional>
+#include <iosfwd>
+
 #include "../utils/avl.hpp"
 #include "core.hpp"
+#include "workspace.hpp"
+
+/**
+ * @brief Callback receiving consecutive chunks of a Newick string
+ */
+typedef std::function<void(std::string_view)> NewickSink;
+
+/**
+ * @brief Default chunk size (in chars) of streamed Newick strings
+ */
+inline constexpr size_t NEWICK_CHUNK_SIZE = 1 << 16;
 
 AVLTree makeTree(const PhyloVec &v);
 
+/**
+ * @brief Build the AVL tree of pairs of v into an existing tree.
+ * The tree is cleared first, and its node pool is reused across calls.
+ * @param v Phylo2Vec vector
+ * @param tree AVL tree to (re)build
+ */
+void makeTree(const PhyloVec &v, AVLTree &tree);
+
+// Below this number of leaves, getPairs inserts pairs directly into a flat array:
+// shifting a few kilobytes of contiguous memory is faster than descending the AVL tree
+inline constexpr size_t SMALL_TREE_LEAVES = 2048;
+
+/**
+ * @brief Get the pairs of v with the insertions of makeTree applied to a flat array
+ * (O(n^2) worst case, used by getPairs below SMALL_TREE_LEAVES leaves)
+ * @param v Phylo2Vec vector
+ * @param pairs output pairs (overwritten)
+ */
+void getPairsFlat(const PhyloVec &v, Pairs &pairs);
+
 Pairs getPairs(const PhyloVec &v);
 
+/**
+ * @brief Get the pairs of v, reusing the storage of a tree and an output buffer
+ * @param v Phylo2Vec vector
+ * @param tree AVL tree used as scratch space
+ * @param pairs output pairs (overwritten)
+ */
+void getPairs(const PhyloVec &v, AVLTree &tree, Pairs &pairs);
+
+/**
+ * @brief Children of the internal nodes of a tree given by its pairs (see getPairs),
+ * labelled as in buildNewick: pair i creates internal node numLeaves + i
+ * @param pairs pairs of the tree (only the first numLeaves - 1 are read,
+ * as getPairs returns one pair for a single leaf)
+ * @param numLeaves number of leaves
+ * @param children output: children of internal node numLeaves + i at index i (overwritten)
+ * @param top scratch space: node at the top of the subtree of each leaf
+ * @return unsigned int root of the tree
+ */
+unsigned int getChildren(const Pairs &pairs, unsigned int numLeaves, Pairs &children,
+                         std::vector<unsigned int> &top);
+
+unsigned int getChildren(const Pairs &pairs, unsigned int numLeaves, Pairs &children);
+
 /**
  * @brief Get ancestry for each node given a v-representation.
  *
@@ -25,22 +82,116 @@ Pairs getPairs(const PhyloVec &v);
  */
 Ancestry getAncestry(const PhyloVec &v);
 
+/**
+ * @brief Exact length of the Newick string of a tree with n leaves
+ * (labels 0..n-1, and n..2n-2 for internal nodes)
+ * @param numLeaves number of leaves
+ * @param withInternals whether internal node labels are written
+ * @return size_t number of characters, including the trailing ';'
+ */
+size_t getNewickLength(size_t numLeaves, bool withInternals = true);
+
 /**
  * @brief
- * Build a Newick string from an "ancestry" array
- * The matrix is processed such that we iteratively write a Newick string
- * to describe the tree.
- * @param ancestry "Ancestry" array of size (n_leaves - 1, 3)
+ * Build a Newick string from pairs of nodes (see getPairs)
+ * The output size is computed up front and the string
+ * is written in a single pre-order pass into one buffer.
+ * @param pairs pairs of nodes of size (n_leaves - 1, 2)
  * @return std::string Newick string
  */
-std::string buildNewick(const Ancestry &ancestry, bool withInternals = true);
+std::string buildNewick(const Pairs &pairs, bool withInternals = true);
+
+/**
+ * @brief Build a Newick string into an existing string
+ * The string is resized to the exact output length,
+ * so its capacity is reused across calls.
+ * @param pairs pairs of nodes of size (n_leaves - 1, 2)
+ * @param newick output string (overwritten)
+ */
+void buildNewick(const Pairs &pairs, std::string &newick, bool withInternals = true);
+
+/**
+ * @brief buildNewick into an existing string, using the scratch space of a workspace
+ */
+void buildNewick(const Pairs &pairs, std::string &newick, ConversionWorkspace &ws,
+                 bool withInternals = true);
+
+/**
+ * @brief Build a Newick string into a caller-provided buffer
+ * The buffer must hold at least getNewickLength(pairs.size() + 1, withInternals) chars.
+ * No null terminator is written.
+ * @param pairs pairs of nodes of size (n_leaves - 1, 2)
+ * @param buffer output buffer
+ * @return size_t number of characters written
+ */
+size_t buildNewick(const Pairs &pairs, char *buffer, bool withInternals = true);
 
 /**
  * @brief Convert a Phylo2Vec vector to a Newick string.
- * Wraps getAncestry and buildNewick
+ * Wraps getPairs and buildNewick
  * @param v Phylo2Vec vector
  * @return std::string Newick string
  */
 std::string toNewick(const PhyloVec &v, bool withInternals = true);
 
+/**
+ * @brief Convert a Phylo2Vec vector to a Newick string written into an existing string
+ * @param v Phylo2Vec vector
+ * @param newick output string (overwritten)
+ */
+void toNewick(const PhyloVec &v, std::string &newick, bool withInternals = true);
+
+/**
+ * @brief toNewick into an existing string, using the scratch space of a workspace
+ * Performs no heap allocation once the workspace and newick have grown to the tree size
+ * @param v Phylo2Vec vector
+ * @param newick output string (overwritten)
+ * @param ws conversion workspace
+ */
+void toNewick(const PhyloVec &v, std::string &newick, ConversionWorkspace &ws,
+              bool withInternals = true);
+
+/**
+ * @brief Convert many Phylo2Vec vectors to Newick strings in parallel
+ * Each thread reuses its own conversion workspace.
+ * @param vs Phylo2Vec vectors
+ * @param numThreads number of threads (0 = all hardware threads)
+ * @return std::vector<std::string> Newick strings, in the same order as vs
+ */
+std::vector<std::string> toNewickBatch(const std::vector<PhyloVec> &vs, bool withInternals = true,
+                                       unsigned int numThreads = 0);
+
+/**
+ * @brief Stream a Newick string to a sink, chunk by chunk
+ * Only one chunk of chars is held in memory at a time:
+ * peak memory is O(n) integers rather than the full output string.
+ * @param pairs pairs of nodes of size (n_leaves - 1, 2)
+ * @param sink callback receiving each chunk
+ * @param chunkSize maximum number of chars per chunk
+ */
+void streamNewick(const Pairs &pairs, const NewickSink &sink, bool withInternals = true,
+                  size_t chunkSize = NEWICK_CHUNK_SIZE);
+
+/**
+ * @brief Stream a Newick string to an output stream
+ * @param pairs pairs of nodes of size (n_leaves - 1, 2)
+ * @param os output stream (e.g., an std::ofstream)
+ */
+void streamNewick(const Pairs &pairs, std::ostream &os, bool withInternals = true);
+
+/**
+ * @brief Convert a Phylo2Vec vector to a Newick string streamed to a sink
+ * Wraps getPairs and streamNewick
+ * @param v Phylo2Vec vector
+ * @param sink callback receiving each chunk
+ */
+void toNewickStream(const PhyloVec &v, const NewickSink &sink, bool withInternals = true);
+
+/**
+ * @brief Convert a Phylo2Vec vector to a Newick string streamed to an output stream
+ * @param v Phylo2Vec vector
+ * @param os output stream (e.g., an std::ofstream)
+ */
+void toNewickStream(const PhyloVec &v, std::ostream &os, bool withInternals = true);
+
 #endif  // TO_NEWICK_HPP
\ No newline at end of file
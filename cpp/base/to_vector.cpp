@@ -1,29 +1,62 @@
 #include "to_vector.hpp"
 
 #include <algorithm>
-#include <charconv>
-#include <numeric>
+#include <sstream>
 #include <stdexcept>
-#include <unordered_map>
-
-#include "../utils/fenwick.hpp"
-
-int stoi_substr(std::string_view s, size_t start, size_t *end) {
-    int value;
-    auto [ptr, ec] = std::from_chars(s.data() + start, s.data() + s.size(), value);
-    if (ec == std::errc()) {
-        *end = ptr - s.data();
-        return value;
-    } else {
-        throw std::logic_error("Bad");
+
+#include "../utils/parallel.hpp"
+
+int parseLabel(std::string_view newick, size_t &i) {
+    const size_t length = newick.length();
+
+    if (i >= length || static_cast<unsigned char>(newick[i] - '0') > 9) {
+        return -1;
     }
+
+    int value = 0;
+    for (unsigned char digit; i < length && (digit = newick[i] - '0') <= 9; ++i) {
+        value = 10 * value + digit;
+    }
+    --i;
+
+    return value;
 }
 
+// Throw if a node label of a Newick string is not below numLabels
+static void checkLabel(int label, size_t numLabels) {
+    if (static_cast<unsigned int>(label) >= numLabels) {
+        std::ostringstream oss;
+        oss << "Node label " << label << " out of range (expected < " << numLabels << ")";
+        throw std::invalid_argument(oss.str());
+    }
+}
+
+// Variants which also record the permutation applied to the cherries
+// (order[i] = index in the input of the i-th output cherry) when order is not null
+static void sortByParent(Ancestry &ancestry, Ancestry &sorted, std::vector<unsigned int> *order);
+static void orderCherries(Ancestry &ancestry, std::vector<unsigned int> *order,
+                          ConversionWorkspace &ws);
+static void orderCherriesNoParents(Ancestry &cherries, std::vector<unsigned int> *order,
+                                   ConversionWorkspace &ws);
+
 Ancestry getCherries(std::string_view newick) {
+    ConversionWorkspace ws;
     Ancestry cherries;
+    getCherries(newick, cherries, ws);
+    return cherries;
+}
+
+void getCherries(std::string_view newick, Ancestry &cherries, ConversionWorkspace &ws) {
+    // A binary tree has one cherry per closing bracket
+    const size_t numCherries = std::count(newick.begin(), newick.end(), ')');
+
+    cherries.clear();
+    cherries.reserve(numCherries);
 
     // Stack of nodes
-    std::vector<int> stack;
+    std::vector<int> &stack = ws.nodeStack;
+    stack.clear();
+    stack.reserve(numCherries + 1);
 
     for (size_t i = 0; i < newick.length(); ++i) {
         char c = newick[i];
@@ -38,9 +71,10 @@ Ancestry getCherries(std::string_view newick) {
             stack.pop_back();
 
             // Get the parent node after )
-            size_t end;
-            int p = stoi_substr(newick, i, &end);
-            i = end - 1;
+            int p = parseLabel(newick, i);
+            if (p == -1) {
+                throw std::logic_error("Bad");
+            }
 
             // Add the triplet (c1, c2, p)
             cherries.push_back({c1, c2, p});
@@ -50,25 +84,29 @@ Ancestry getCherries(std::string_view newick) {
             stack.push_back(p);
         } else if (c >= '0' && c <= '9') {
             // Get the next node and push it to the stack
-            size_t end;
-            int node = stoi_substr(newick, i, &end);
-            stack.push_back(node);
-            i = end - 1;
+            stack.push_back(parseLabel(newick, i));
         }
     }
-
-    return cherries;
 }
 
 Ancestry getCherriesNoParents(std::string_view newick) {
-    const size_t newickLength = newick.length();
-
+    ConversionWorkspace ws;
     Ancestry ancestry;
-    ancestry.reserve(newickLength);
+    getCherriesNoParents(newick, ancestry, ws);
+    return ancestry;
+}
+
+void getCherriesNoParents(std::string_view newick, Ancestry &ancestry, ConversionWorkspace &ws) {
+    const size_t numCherries = std::count(newick.begin(), newick.end(), ')');
+
+    ancestry.clear();
+    ancestry.reserve(numCherries);
 
-    std::vector<int> stack;
+    std::vector<int> &stack = ws.nodeStack;
+    stack.clear();
+    stack.reserve(numCherries + 1);
 
-    for (size_t i = 0; i < newickLength; ++i) {
+    for (size_t i = 0; i < newick.length(); ++i) {
         char c = newick[i];
 
         if (c == ')') {
@@ -88,17 +126,82 @@ Ancestry getCherriesNoParents(std::string_view newick) {
             stack.push_back(cMin);
         } else if (c >= '0' && c <= '9') {
             // Get the next leaf and push it to the stack
-            size_t end;
-            int leaf = stoi_substr(newick, i, &end);
-            stack.push_back(leaf);
-            i = end - 1;
+            stack.push_back(parseLabel(newick, i));
         }
     }
+}
 
-    return ancestry;
+void sortByParent(Ancestry &ancestry) {
+    Ancestry sorted;
+    sortByParent(ancestry, sorted);
+}
+
+void sortByParent(Ancestry &ancestry, Ancestry &sorted) {
+    sortByParent(ancestry, sorted, nullptr);
+}
+
+static void sortByParent(Ancestry &ancestry, Ancestry &sorted, std::vector<unsigned int> *order) {
+    const size_t numCherries = ancestry.size();
+    const int numLeaves = numCherries + 1;
+
+    // Parents are usually the dense range numLeaves..2 * numLeaves - 2
+    // --> place each row directly at index parent - numLeaves
+    sorted.assign(numCherries, {0, 0, -1});
+    if (order != nullptr) {
+        order->resize(numCherries);
+    }
+
+    for (size_t i = 0; i < numCherries; ++i) {
+        size_t idx = ancestry[i][2] - numLeaves;
+
+        if (idx >= numCherries || sorted[idx][2] != -1) {
+            // Not a dense range of distinct parents: fall back to a comparison sort
+            if (order == nullptr) {
+                std::sort(ancestry.begin(), ancestry.end(),
+                          [](const std::array<int, 3> &a, const std::array<int, 3> &b) {
+                              return a[2] < b[2];
+                          });
+                return;
+            }
+
+            std::vector<unsigned int> &idxs = *order;
+            for (size_t j = 0; j < numCherries; ++j) {
+                idxs[j] = j;
+            }
+            std::stable_sort(idxs.begin(), idxs.end(), [&ancestry](unsigned int a, unsigned int b) {
+                return ancestry[a][2] < ancestry[b][2];
+            });
+            for (size_t j = 0; j < numCherries; ++j) {
+                sorted[j] = ancestry[idxs[j]];
+            }
+            break;
+        }
+
+        sorted[idx] = ancestry[i];
+        if (order != nullptr) {
+            (*order)[idx] = i;
+        }
+    }
+
+    // Swap rather than move, so that both buffers are kept for later calls
+    std::swap(ancestry, sorted);
 }
 
 void orderCherries(Ancestry &ancestry) {
+    ConversionWorkspace ws;
+    orderCherries(ancestry, ws);
+}
+
+void orderCherries(Ancestry &ancestry, ConversionWorkspace &ws) {
+    orderCherries(ancestry, nullptr, ws);
+}
+
+void orderCherries(Ancestry &ancestry, std::vector<unsigned int> &order, ConversionWorkspace &ws) {
+    orderCherries(ancestry, &order, ws);
+}
+
+static void orderCherries(Ancestry &ancestry, std::vector<unsigned int> *order,
+                          ConversionWorkspace &ws) {
     const size_t numCherries = ancestry.size();
     const size_t numNodes = 2 * numCherries + 1;
 
@@ -106,18 +209,17 @@ void orderCherries(Ancestry &ancestry) {
     // This allows us to reconstruct the triplets as they should appear
     // using the Phylo2Vec construction
     // Note: the first numLeaves indices are not used
-    std::vector<int> minDesc(numNodes, -1);
+    std::vector<int> &minDesc = ws.minDesc;
+    minDesc.assign(numNodes, -1);
 
     // Sort the ancestry by their parent node (ascending order)
-    std::qsort(ancestry.data(), numCherries, sizeof(std::array<int, 3>),
-               [](const void *a, const void *b) {
-                   const auto &arr1 = *static_cast<const std::array<int, 3> *>(a);
-                   const auto &arr2 = *static_cast<const std::array<int, 3> *>(b);
-                   return arr1[2] - arr2[2];
-               });
+    sortByParent(ancestry, ws.sorted, order);
 
     for (size_t i = 0; i < numCherries; ++i) {
         auto &[c1, c2, p] = ancestry[i];
+        checkLabel(c1, numNodes);
+        checkLabel(c2, numNodes);
+        checkLabel(p, numNodes);
 
         // Get the minimum descendant of c1 and c2 (if they exist)
         // minDesc[child_x] doesn't exist, minDesc_x --> child_x
@@ -135,47 +237,91 @@ void orderCherries(Ancestry &ancestry) {
 }
 
 void orderCherriesNoParents(Ancestry &cherries) {
-    std::vector<int> leaves;
-    std::unordered_map<int, int> visited;
+    ConversionWorkspace ws;
+    orderCherriesNoParents(cherries, ws);
+}
+
+void orderCherriesNoParents(Ancestry &cherries, ConversionWorkspace &ws) {
+    orderCherriesNoParents(cherries, nullptr, ws);
+}
+
+void orderCherriesNoParents(Ancestry &cherries, std::vector<unsigned int> &order,
+                            ConversionWorkspace &ws) {
+    orderCherriesNoParents(cherries, &order, ws);
+}
+
+static void orderCherriesNoParents(Ancestry &cherries, std::vector<unsigned int> *order,
+                                   ConversionWorkspace &ws) {
+    const size_t numCherries = cherries.size();
+    const size_t numLeaves = numCherries + 1;
+
+    // Leaf to process for each cherry
+    std::vector<int> &leaves = ws.leaves;
+    leaves.resize(numCherries);
 
-    for (size_t i = 0; i < cherries.size(); ++i) {
+    // Last leaf processed in the subtree of a (min) leaf, -1 if not visited
+    std::vector<int> &visited = ws.visited;
+    visited.assign(numLeaves, -1);
+
+    for (size_t i = 0; i < numCherries; ++i) {
         auto &[c1, c2, cMax] = cherries[i];
+        checkLabel(c1, numLeaves);
+        checkLabel(c2, numLeaves);
+        checkLabel(cMax, numLeaves);
         int cMin = std::min(c1, c2);
 
         int toProcess = cMax;
 
-        if (visited.find(cMin) != visited.end() && visited[cMin] < cMax) {
+        if (visited[cMin] != -1 && visited[cMin] < cMax) {
             toProcess = visited[cMin];
         }
 
-        leaves.push_back(toProcess);
+        leaves[i] = toProcess;
         visited[cMin] = toProcess;
     }
 
-    // argsort with descending order
-    // argsort used here for to_matrix to reorder BLs
-    std::vector<size_t> indices(cherries.size());
-    std::iota(indices.begin(), indices.end(), 0);
-    // stable sort is important to keep the order of cherries
-    std::stable_sort(indices.begin(), indices.end(),
-                     [&leaves](size_t i, size_t j) { return leaves[i] > leaves[j]; });
-
-    // Reorder the cherries in place using the sorted indices
-    Ancestry temp;
-    temp.reserve(cherries.size());
-    for (size_t i : indices) {
-        temp.push_back(cherries[i]);
+    // Stable counting sort of the cherries by leaf (descending order)
+    // stable is important to keep the order of cherries
+    std::vector<size_t> &offsets = ws.offsets;
+    offsets.assign(numLeaves + 1, 0);
+    for (size_t i = 0; i < numCherries; ++i) {
+        ++offsets[numLeaves - 1 - leaves[i] + 1];
+    }
+    for (size_t j = 1; j <= numLeaves; ++j) {
+        offsets[j] += offsets[j - 1];
+    }
+
+    // Reorder the cherries using the sorted positions
+    Ancestry &temp = ws.sorted;
+    temp.resize(numCherries);
+    if (order != nullptr) {
+        order->resize(numCherries);
     }
-    cherries = std::move(temp);
+    for (size_t i = 0; i < numCherries; ++i) {
+        size_t idx = offsets[numLeaves - 1 - leaves[i]]++;
+        temp[idx] = cherries[i];
+        if (order != nullptr) {
+            (*order)[idx] = i;
+        }
+    }
+    std::swap(cherries, temp);
 }
 
 PhyloVec buildVector(Ancestry cherries) {
+    ConversionWorkspace ws;
+    PhyloVec v;
+    buildVector(cherries, v, ws);
+    return v;
+}
+
+void buildVector(const Ancestry &cherries, PhyloVec &v, ConversionWorkspace &ws) {
     const size_t numCherries = cherries.size();
     const size_t numLeaves = numCherries + 1;
 
-    PhyloVec v(numCherries, 0);
+    v.assign(numCherries, 0);
 
-    FenwickTree bit(numLeaves);
+    FenwickTree &bit = ws.bit;
+    bit.reset(numLeaves);
 
     // Note: v[0] is always 0
     // but starting with i = 1 makes some tests fail (weird)
@@ -189,26 +335,66 @@ PhyloVec buildVector(Ancestry cherries) {
 
         bit.update(cMax, 1);
     }
+}
 
+PhyloVec toVector(std::string_view newick) {
+    ConversionWorkspace ws;
+    PhyloVec v;
+    toVector(newick, v, ws);
     return v;
 }
 
-PhyloVec toVector(std::string_view newick) {
-    Ancestry ancestry = getCherries(newick.substr(0, newick.length() - 1));
+void toVector(std::string_view newick, PhyloVec &v, ConversionWorkspace &ws) {
+    getCherries(newick.substr(0, newick.length() - 1), ws.ancestry, ws);
 
-    orderCherries(ancestry);
+    orderCherries(ws.ancestry, ws);
 
-    PhyloVec v = buildVector(ancestry);
+    buildVector(ws.ancestry, v, ws);
+}
 
+PhyloVec toVectorNoParents(std::string_view newick) {
+    ConversionWorkspace ws;
+    PhyloVec v;
+    toVectorNoParents(newick, v, ws);
     return v;
 }
 
-PhyloVec toVectorNoParents(std::string_view newick) {
-    Ancestry ancestry = getCherriesNoParents(newick.substr(0, newick.length() - 1));
+void toVectorNoParents(std::string_view newick, PhyloVec &v, ConversionWorkspace &ws) {
+    getCherriesNoParents(newick.substr(0, newick.length() - 1), ws.ancestry, ws);
 
-    orderCherriesNoParents(ancestry);
+    orderCherriesNoParents(ws.ancestry, ws);
 
-    PhyloVec v = buildVector(ancestry);
+    buildVector(ws.ancestry, v, ws);
+}
 
-    return v;
-}
\ No newline at end of file
+std::vector<PhyloVec> toVectorBatch(const std::vector<std::string_view> &newicks,
+                                    unsigned int numThreads) {
+    std::vector<PhyloVec> vs(newicks.size());
+
+    numThreads = getNumThreads(numThreads);
+
+    // Per-thread scratch space
+    std::vector<ConversionWorkspace> workspaces(numThreads);
+
+    parallelFor(newicks.size(), numThreads, [&](size_t i, unsigned int t) {
+        toVector(newicks[i], vs[i], workspaces[t]);
+    });
+
+    return vs;
+}
+
+std::vector<PhyloVec> toVectorNoParentsBatch(const std::vector<std::string_view> &newicks,
+                                             unsigned int numThreads) {
+    std::vector<PhyloVec> vs(newicks.size());
+
+    numThreads = getNumThreads(numThreads);
+
+    // Per-thread scratch space
+    std::vector<ConversionWorkspace> workspaces(numThreads);
+
+    parallelFor(newicks.size(), numThreads, [&](size_t i, unsigned int t) {
+        toVectorNoParents(newicks[i], vs[i], workspaces[t]);
+    });
+
+    return vs;
+}
@@ -7,6 +7,15 @@
  */
 
 #include "core.hpp"
+#include "workspace.hpp"
+
+/**
+ * @brief Parse the integer label starting at newick[i]
+ * @param newick Newick string
+ * @param i position of the label, moved to its last digit
+ * @return int label, or -1 if there is no label at newick[i]
+ */
+int parseLabel(std::string_view newick, size_t &i);
 
 /**
  * @brief Get all "cherries" from a Newick string with parents
@@ -24,6 +33,11 @@
  */
 Ancestry getCherries(std::string_view newick);
 
+/**
+ * @brief getCherries into an existing ancestry, using the scratch space of a workspace
+ */
+void getCherries(std::string_view newick, Ancestry &cherries, ConversionWorkspace &ws);
+
 /**
  * @brief Get all "cherries" from a Newick string without
  * internal node annotations
@@ -41,6 +55,24 @@ Ancestry getCherries(std::string_view newick);
  */
 Ancestry getCherriesNoParents(std::string_view newick);
 
+/**
+ * @brief getCherriesNoParents into an existing ancestry, using the scratch space of a workspace
+ */
+void getCherriesNoParents(std::string_view newick, Ancestry &ancestry, ConversionWorkspace &ws);
+
+/**
+ * @brief Sort cherry triplets {child1, child2, parent} by parent (ascending order)
+ * In O(n) when parents are the dense range n..2n-2 (as in toNewick outputs),
+ * with a comparison sort fallback otherwise.
+ * @param ancestry vector of cherry triplets {child1, child2, parent}
+ */
+void sortByParent(Ancestry &ancestry);
+
+/**
+ * @brief sortByParent using a scratch ancestry (swapped with the input when sorted)
+ */
+void sortByParent(Ancestry &ancestry, Ancestry &sorted);
+
 /**
  * @brief Order all cherries according to their height
  * (i.e., from leaf-level cherries to the root-level pairs).
@@ -75,9 +107,24 @@ Ancestry getCherriesNoParents(std::string_view newick);
  * 0 1 1
  * @param ancestry vector of cherry triplets {child1, child2, max(child1,
  * child2)}
+ * @throws std::invalid_argument if a label is not in [0, 2 * ancestry.size()]
  */
 void orderCherries(Ancestry &ancestry);
 
+/**
+ * @brief orderCherries using the scratch space of a workspace
+ */
+void orderCherries(Ancestry &ancestry, ConversionWorkspace &ws);
+
+/**
+ * @brief orderCherries, also returning the permutation applied to the cherries
+ * (e.g., to reorder per-cherry data such as branch lengths)
+ * @param ancestry vector of cherry triplets {child1, child2, parent}
+ * @param order output: order[i] = index in the input of the i-th ordered cherry
+ * @param ws conversion workspace
+ */
+void orderCherries(Ancestry &ancestry, std::vector<unsigned int> &order, ConversionWorkspace &ws);
+
 /**
  * @brief Order all cherries according to their height
  * without internal node annotations
@@ -116,9 +163,24 @@ void orderCherries(Ancestry &ancestry);
  * 0 1 1
  * @param ancestry vector of cherry triplets {child1, child2, max(child1,
  * child2)}
+ * @throws std::invalid_argument if a label is not in [0, ancestry.size()]
  */
 void orderCherriesNoParents(Ancestry &ancestry);
 
+/**
+ * @brief orderCherriesNoParents using the scratch space of a workspace
+ */
+void orderCherriesNoParents(Ancestry &ancestry, ConversionWorkspace &ws);
+
+/**
+ * @brief orderCherriesNoParents, also returning the permutation applied to the cherries
+ * @param ancestry vector of cherry triplets {child1, child2, max(child1, child2)}
+ * @param order output: order[i] = index in the input of the i-th ordered cherry
+ * @param ws conversion workspace
+ */
+void orderCherriesNoParents(Ancestry &ancestry, std::vector<unsigned int> &order,
+                            ConversionWorkspace &ws);
+
 /**
  * @brief construct a Phylo2Vec vector from cherry triplets
  *
@@ -128,20 +190,57 @@ void orderCherriesNoParents(Ancestry &ancestry);
  */
 PhyloVec buildVector(Ancestry cherries);
 
+/**
+ * @brief buildVector into an existing vector, using the scratch space of a workspace
+ */
+void buildVector(const Ancestry &cherries, PhyloVec &v, ConversionWorkspace &ws);
+
 /**
  * @brief Convert a newick (with parent annotations) to a Phylo2Vec vector
  * Wrapper of getCherries + orderCherries + buildVector
  * @param newick Newick string with parent labels
  * @return PhyloVec: v[i] = j <=> leaf j descends from branch i
+ * @throws std::invalid_argument if a label is out of range for the number of leaves
  */
 PhyloVec toVector(std::string_view newick);
 
+/**
+ * @brief toVector into an existing vector, using the scratch space of a workspace
+ * Performs no heap allocation once the workspace and v have grown to the tree size
+ */
+void toVector(std::string_view newick, PhyloVec &v, ConversionWorkspace &ws);
+
 /**
  * @brief Convert a newick (without parent annotations) to a Phylo2Vec vector
  *Wrapper of getCherriesNoParents + orderCherriesNoParents + buildVector
  * @param newick_no_parents Newick string without parent labels
  * @return PhyloVec: v[i] = j <=> leaf j descends from branch i
+ * @throws std::invalid_argument if a label is out of range for the number of leaves
  */
 PhyloVec toVectorNoParents(std::string_view newick_no_parents);
 
+/**
+ * @brief toVectorNoParents into an existing vector, using the scratch space of a workspace
+ * Performs no heap allocation once the workspace and v have grown to the tree size
+ */
+void toVectorNoParents(std::string_view newick_no_parents, PhyloVec &v, ConversionWorkspace &ws);
+
+/**
+ * @brief Convert many Newick strings (with parent labels) to vectors in parallel
+ * @param newicks Newick strings with parent labels
+ * @param numThreads number of threads (0 = all hardware threads)
+ * @return std::vector<PhyloVec> vectors, in the same order as newicks
+ */
+std::vector<PhyloVec> toVectorBatch(const std::vector<std::string_view> &newicks,
+                                    unsigned int numThreads = 0);
+
+/**
+ * @brief Convert many Newick strings (without parent labels) to vectors in parallel
+ * @param newicks Newick strings without parent labels
+ * @param numThreads number of threads (0 = all hardware threads)
+ * @return std::vector<PhyloVec> vectors, in the same order as newicks
+ */
+std::vector<PhyloVec> toVectorNoParentsBatch(const std::vector<std::string_view> &newicks,
+                                             unsigned int numThreads = 0);
+
 #endif  // TO_VECTOR_HPP
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef WORKSPACE_HPP
+#define WORKSPACE_HPP
+
+/**
+ * @file workspace.hpp
+ * @brief Reusable scratch space for the base conversion functions
+ */
+
+#include "../utils/avl.hpp"
+#include "../utils/fenwick.hpp"
+#include "core.hpp"
+
+/**
+ * @brief Scratch buffers used by toNewick, toVector, toMatrix and their variants
+ * Buffers only grow: once a workspace has converted a tree of n leaves,
+ * converting trees of at most n leaves performs no heap allocation
+ * (when the outputs are also reused, see the overloads taking a workspace).
+ * A workspace must not be shared between threads.
+ */
+struct ConversionWorkspace {
+    // Vector --> Newick
+    AVLTree tree;
+    Pairs pairs;
+    std::vector<Pair> children;
+    std::vector<unsigned int> subtreeTops;
+    std::vector<unsigned int> writeStack;
+
+    // Newick --> vector
+    Ancestry ancestry;
+    Ancestry sorted;
+    std::vector<int> nodeStack;
+    std::vector<int> minDesc;
+    std::vector<int> leaves;
+    std::vector<int> visited;
+    std::vector<size_t> offsets;
+    std::vector<unsigned int> order;
+    FenwickTree bit;
+
+    // Newick with branch lengths --> matrix
+    // (stored in double, which holds float and double branch lengths exactly)
+    std::vector<std::array<double, 2>> branches;
+    std::vector<double> branchStack;
+};
+
+#endif  // WORKSPACE_HPP
@@ -1,10 +1,45 @@
 #include <benchmark/benchmark.h>
 
+#include <cstdio>
+#include <fstream>
+#include <random>
+
 #include "../base/core.hpp"
 #include "../base/to_newick.hpp"
 #include "../base/to_vector.hpp"
+#include "../io/packed.hpp"
+#include "../io/tree_file.hpp"
+#include "../matrix/to_matrix.hpp"
+#include "../matrix/to_newick.hpp"
+#include "../metrics/kendall_colijn.hpp"
+#include "../metrics/pairwise.hpp"
+#include "../metrics/robinson_foulds.hpp"
+#include "../metrics/shape.hpp"
+#include "../ops/dynamic_tree.hpp"
+#include "../ops/neighbourhood.hpp"
 #include "../ops/newick.hpp"
+#include "../ops/tree_index.hpp"
 #include "../ops/vector.hpp"
+#include "../opt/hill_climbing.hpp"
+#include "../opt/losses.hpp"
+
+// Number of trees per batch in the batch benchmarks
+const size_t BATCH_SIZE = 64;
+
+// Add random branch lengths to a Newick string (with or without parent labels)
+std::string addBranchLengths(const std::string &newick) {
+    std::string result;
+    result.reserve(2 * newick.size());
+    for (size_t i = 0; i < newick.size(); ++i) {
+        result += newick[i];
+        bool endOfNode = (isdigit(newick[i]) || newick[i] == ')') && i + 1 < newick.size() &&
+                         !isdigit(newick[i + 1]) && newick[i + 1] != ';';
+        if (endOfNode) {
+            result += ':' + std::to_string(rand() / static_cast<double>(RAND_MAX));
+        }
+    }
+    return result;
+}
 
 // Benchmark sample
 static void BM_sample(benchmark::State &state) {
@@ -16,6 +51,45 @@ static void BM_sample(benchmark::State &state) {
     }
 }
 
+// Benchmark sampleMany on a batch of vectors
+static void BM_sampleMany(benchmark::State &state) {
+    int n = state.range(0);
+    for (auto _ : state) {
+        std::vector<unsigned int> vs = sampleMany(BATCH_SIZE, n, 42);
+        benchmark::DoNotOptimize(vs);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * BATCH_SIZE);
+}
+
+// Benchmark getPairs (AVL tree construction + traversal)
+static void BM_getPairs(benchmark::State &state) {
+    int n = state.range(0);
+    for (auto _ : state) {
+        state.PauseTiming();
+        PhyloVec v = sample(n, false);
+        state.ResumeTiming();
+        Pairs pairs = getPairs(v);
+        benchmark::DoNotOptimize(pairs);
+        benchmark::ClobberMemory();
+    }
+}
+
+// Benchmark getPairs, reusing the AVL node pool and the output buffer
+static void BM_getPairsReuse(benchmark::State &state) {
+    int n = state.range(0);
+    AVLTree tree;
+    Pairs pairs;
+    for (auto _ : state) {
+        state.PauseTiming();
+        PhyloVec v = sample(n, false);
+        state.ResumeTiming();
+        getPairs(v, tree, pairs);
+        benchmark::DoNotOptimize(pairs);
+        benchmark::ClobberMemory();
+    }
+}
+
 // Benchmark toNewick
 static void BM_toNewick(benchmark::State &state) {
     int n = state.range(0);
@@ -29,41 +103,567 @@ static void BM_toNewick(benchmark::State &state) {
     }
 }
 
+// Benchmark toNewick, writing into a reused output string
+static void BM_toNewickReuse(benchmark::State &state) {
+    int n = state.range(0);
+    std::string newick;
+    for (auto _ : state) {
+        state.PauseTiming();
+        PhyloVec v = sample(n, false);
+        state.ResumeTiming();
+        toNewick(v, newick);
+        benchmark::DoNotOptimize(newick);
+        benchmark::ClobberMemory();
+    }
+}
+
+// Benchmark toNewick with a reused conversion workspace
+static void BM_toNewickWorkspace(benchmark::State &state) {
+    int n = state.range(0);
+    ConversionWorkspace ws;
+    std::string newick;
+    for (auto _ : state) {
+        state.PauseTiming();
+        PhyloVec v = sample(n, false);
+        state.ResumeTiming();
+        toNewick(v, newick, ws);
+        benchmark::DoNotOptimize(newick);
+        benchmark::ClobberMemory();
+    }
+}
+
+// Benchmark toNewickStream, with a sink which only counts chars
+static void BM_toNewickStream(benchmark::State &state) {
+    int n = state.range(0);
+    for (auto _ : state) {
+        state.PauseTiming();
+        PhyloVec v = sample(n, false);
+        state.ResumeTiming();
+        size_t length = 0;
+        toNewickStream(v, [&length](std::string_view chunk) { length += chunk.size(); });
+        benchmark::DoNotOptimize(length);
+        benchmark::ClobberMemory();
+    }
+}
+
 // Benchmark toVector
 static void BM_toVector(benchmark::State &state) {
     int n = state.range(0);
+    int64_t bytes = 0;
     for (auto _ : state) {
         state.PauseTiming();
         PhyloVec v1 = sample(n, false);
         std::string newick = toNewick(v1);
+        bytes += newick.size();
         state.ResumeTiming();
         PhyloVec v2 = toVector(newick);
         benchmark::DoNotOptimize(v2);
         benchmark::ClobberMemory();
     }
+    state.SetBytesProcessed(bytes);
+}
+
+// Benchmark toVector with a reused conversion workspace
+static void BM_toVectorWorkspace(benchmark::State &state) {
+    int n = state.range(0);
+    int64_t bytes = 0;
+    ConversionWorkspace ws;
+    PhyloVec v2;
+    for (auto _ : state) {
+        state.PauseTiming();
+        PhyloVec v1 = sample(n, false);
+        std::string newick = toNewick(v1);
+        bytes += newick.size();
+        state.ResumeTiming();
+        toVector(newick, v2, ws);
+        benchmark::DoNotOptimize(v2);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(bytes);
+}
+
+// Benchmark toMatrix for a branch length type and layout
+template <typename T, BranchLayout Layout>
+static void BM_toMatrix(benchmark::State &state) {
+    int n = state.range(0);
+    int64_t bytes = 0;
+    ConversionWorkspace ws;
+    BasicPhyloMat<T, Layout> m;
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::string newick = addBranchLengths(toNewick(sample(n, false)));
+        bytes += newick.size();
+        state.ResumeTiming();
+        toMatrix(newick, m, ws);
+        benchmark::DoNotOptimize(m);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(bytes);
+}
+
+// Benchmark toMatrixNoParents
+static void BM_toMatrixNoParents(benchmark::State &state) {
+    int n = state.range(0);
+    int64_t bytes = 0;
+    ConversionWorkspace ws;
+    PhyloMat m;
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::string newick = addBranchLengths(toNewick(sample(n, false), false));
+        bytes += newick.size();
+        state.ResumeTiming();
+        toMatrixNoParents(newick, m, ws);
+        benchmark::DoNotOptimize(m);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(bytes);
+}
+
+// Benchmark toNewick with branch lengths
+// Arguments: number of leaves, precision (-1 = shortest round-trip)
+static void BM_toNewickWithBranches(benchmark::State &state) {
+    int n = state.range(0);
+    int precision = state.range(1);
+    PhyloMat m;
+    m.v = sample(n, false);
+    for (size_t i = 0; i < m.v.size(); ++i) {
+        m.branches.push_back({rand() / static_cast<float>(RAND_MAX),
+                              rand() / static_cast<float>(RAND_MAX)});
+    }
+    for (auto _ : state) {
+        std::string newick = toNewick(m, precision);
+        benchmark::DoNotOptimize(newick);
+        benchmark::ClobberMemory();
+    }
 }
 
 // Benchmark toVectorNoParents
 static void BM_toVectorNoParents(benchmark::State &state) {
     int n = state.range(0);
+    int64_t bytes = 0;
     for (auto _ : state) {
         state.PauseTiming();
         PhyloVec v1 = sample(n, false);
         std::string newick = toNewick(v1, false);
+        bytes += newick.size();
         state.ResumeTiming();
         PhyloVec v2 = toVectorNoParents(newick);
         benchmark::DoNotOptimize(v2);
         benchmark::ClobberMemory();
     }
+    state.SetBytesProcessed(bytes);
+}
+
+// Benchmark toNewickBatch on a batch of vectors
+// Arguments: number of leaves, number of threads
+static void BM_toNewickBatch(benchmark::State &state) {
+    int n = state.range(0);
+    unsigned int numThreads = state.range(1);
+    std::vector<PhyloVec> vs;
+    for (size_t i = 0; i < BATCH_SIZE; ++i) {
+        vs.push_back(sample(n, false));
+    }
+    for (auto _ : state) {
+        std::vector<std::string> newicks = toNewickBatch(vs, true, numThreads);
+        benchmark::DoNotOptimize(newicks);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * BATCH_SIZE);
+}
+
+// Benchmark toVectorBatch on a batch of Newick strings
+// Arguments: number of leaves, number of threads
+static void BM_toVectorBatch(benchmark::State &state) {
+    int n = state.range(0);
+    unsigned int numThreads = state.range(1);
+    std::vector<std::string> newicks;
+    for (size_t i = 0; i < BATCH_SIZE; ++i) {
+        newicks.push_back(toNewick(sample(n, false)));
+    }
+    std::vector<std::string_view> views(newicks.begin(), newicks.end());
+    for (auto _ : state) {
+        std::vector<PhyloVec> vs = toVectorBatch(views, numThreads);
+        benchmark::DoNotOptimize(vs);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * BATCH_SIZE);
+}
+
+// Benchmark readTreeFile on a file of BATCH_SIZE trees
+// Arguments: number of leaves, number of threads
+static void BM_readTreeFile(benchmark::State &state) {
+    int n = state.range(0);
+    unsigned int numThreads = state.range(1);
+    std::string path = "phylo2vec_bench_trees.nwk";
+    {
+        std::ofstream out(path);
+        for (size_t i = 0; i < BATCH_SIZE; ++i) {
+            out << toNewick(sample(n, false)) << '\n';
+        }
+    }
+    MappedFile file(path);
+    for (auto _ : state) {
+        VectorCollection collection = readTreeFile(file, NewickLabels::Parents, numThreads);
+        benchmark::DoNotOptimize(collection);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * file.size());
+    std::remove(path.c_str());
+}
+
+// Benchmark packVector (bytes = size of the unpacked vector)
+static void BM_packVector(benchmark::State &state) {
+    int n = state.range(0);
+    PhyloVec v = sample(n, false);
+    std::vector<char> record(getPackedRecordSize(n));
+    for (auto _ : state) {
+        packVector(v, record.data());
+        benchmark::DoNotOptimize(record.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * v.size() * sizeof(unsigned int));
+}
+
+// Benchmark unpackVector (bytes = size of the unpacked vector)
+static void BM_unpackVector(benchmark::State &state) {
+    int n = state.range(0);
+    PhyloVec v = sample(n, false);
+    std::vector<char> record(getPackedRecordSize(n));
+    packVector(v, record.data());
+    PhyloVec unpacked;
+    for (auto _ : state) {
+        unpackVector(record.data(), n, unpacked);
+        benchmark::DoNotOptimize(unpacked.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * v.size() * sizeof(unsigned int));
+}
+
+// Benchmark copheneticDistances (bytes = size of the condensed output)
+static void BM_copheneticDistances(benchmark::State &state) {
+    int n = state.range(0);
+    PhyloVec v = sample(n, false);
+    std::vector<float> distances(getDistanceMatrixSize(n, DistanceLayout::Condensed));
+    for (auto _ : state) {
+        copheneticDistances(v, distances.data(), DistanceLayout::Condensed);
+        benchmark::DoNotOptimize(distances.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * distances.size() * sizeof(float));
+}
+
+// Benchmark patristicDistances (bytes = size of the condensed output)
+static void BM_patristicDistances(benchmark::State &state) {
+    int n = state.range(0);
+    PhyloMat m{sample(n, false), std::vector<std::array<float, 2>>(n - 1, {0.5f, 1.5f})};
+    std::vector<float> distances(getDistanceMatrixSize(n, DistanceLayout::Condensed));
+    for (auto _ : state) {
+        patristicDistances(m, distances.data(), DistanceLayout::Condensed);
+        benchmark::DoNotOptimize(distances.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * distances.size() * sizeof(float));
+}
+
+// Benchmark writeCopheneticDistances to a condensed distance file
+static void BM_writeCopheneticDistances(benchmark::State &state) {
+    int n = state.range(0);
+    PhyloVec v = sample(n, false);
+    std::string path = "/tmp/phylo2vec_bench_distances.bin";
+    for (auto _ : state) {
+        writeCopheneticDistances(path, v, DistanceLayout::Condensed);
+    }
+    state.SetBytesProcessed(state.iterations() *
+                            getDistanceMatrixSize(n, DistanceLayout::Condensed) * sizeof(float));
+    std::remove(path.c_str());
+}
+
+// Benchmark robinsonFouldsAllPairs on K trees of 500 leaves
+// drawn from a given number of distinct trees (items = pairs of trees)
+static void BM_robinsonFouldsAllPairs(benchmark::State &state) {
+    const size_t numTrees = state.range(0);
+    const size_t numDistinct = state.range(1);
+    std::vector<PhyloVec> vs;
+    for (size_t i = 0; i < numTrees; ++i) {
+        vs.push_back(sample(500, false, 42, i % numDistinct));
+    }
+    for (auto _ : state) {
+        std::vector<unsigned int> distances = robinsonFouldsAllPairs(vs, true);
+        benchmark::DoNotOptimize(distances.data());
+    }
+    state.SetItemsProcessed(state.iterations() * numTrees * (numTrees - 1) / 2);
+}
+
+// Benchmark kendallColijnAllPairs on K random trees of 500 leaves (items = pairs of trees)
+static void BM_kendallColijnAllPairs(benchmark::State &state) {
+    const size_t numTrees = state.range(0);
+    std::vector<PhyloVec> vs;
+    for (size_t i = 0; i < numTrees; ++i) {
+        vs.push_back(sample(500, false, 42, i));
+    }
+    for (auto _ : state) {
+        std::vector<double> distances = kendallColijnAllPairs(vs);
+        benchmark::DoNotOptimize(distances.data());
+    }
+    state.SetItemsProcessed(state.iterations() * numTrees * (numTrees - 1) / 2);
+}
+
+// Benchmark getShapeStatsBatch on a contiguous block of 100k trees of 100 leaves
+// Arguments: with depth counts, number of threads
+static void BM_shapeStatsBatch(benchmark::State &state) {
+    const size_t numTrees = 100000;
+    const bool withDepthCounts = state.range(0);
+    unsigned int numThreads = state.range(1);
+    std::vector<unsigned int> block;
+    for (size_t i = 0; i < numTrees; ++i) {
+        PhyloVec v = sample(100, false);
+        block.insert(block.end(), v.begin(), v.end());
+    }
+    for (auto _ : state) {
+        ShapeStatsBatch batch =
+            getShapeStatsBatch(block.data(), numTrees, 100, withDepthCounts, numThreads);
+        benchmark::DoNotOptimize(batch);
+    }
+    state.SetItemsProcessed(state.iterations() * numTrees);
+}
+
+// Benchmark building a TreeIndex
+static void BM_treeIndex(benchmark::State &state) {
+    int n = state.range(0);
+    PhyloVec v = sample(n, false);
+    for (auto _ : state) {
+        TreeIndex index(v);
+        benchmark::DoNotOptimize(index);
+    }
+}
+
+// Benchmark TreeIndex::distanceBatch on 1M random leaf pairs
+static void BM_treeIndexDistanceBatch(benchmark::State &state) {
+    int n = state.range(0);
+    PhyloVec v = sample(n, false);
+    TreeIndex index(v);
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<unsigned int> leafDistr(0, n - 1);
+    Pairs pairs(1 << 20);
+    for (auto &pair : pairs) {
+        pair = {leafDistr(gen), leafDistr(gen)};
+    }
+    for (auto _ : state) {
+        std::vector<unsigned int> distances = index.distanceBatch(pairs, false, state.range(1));
+        benchmark::DoNotOptimize(distances.data());
+    }
+    state.SetItemsProcessed(state.iterations() * pairs.size());
+}
+
+// Benchmark the pairs of the 2i + 1 proposals of the middle entry, rebuilt from scratch
+static void BM_neighbourhoodNaive(benchmark::State &state) {
+    int n = state.range(0);
+    PhyloVec v = sample(n, false);
+    const size_t index = n / 2;
+    AVLTree tree;
+    Pairs pairs;
+    for (auto _ : state) {
+        PhyloVec proposal = v;
+        for (unsigned int j = 0; j <= 2 * index; ++j) {
+            proposal[index] = j;
+            getPairs(proposal, tree, pairs);
+            benchmark::DoNotOptimize(pairs.data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * (2 * index + 1));
+}
+
+// Benchmark the same proposals with Neighbourhood
+static void BM_neighbourhood(benchmark::State &state) {
+    int n = state.range(0);
+    PhyloVec v = sample(n, false);
+    const size_t index = n / 2;
+    Neighbourhood neighbourhood;
+    for (auto _ : state) {
+        neighbourhood.forEach(v, index, [](unsigned int, const Pairs &pairs) {
+            benchmark::DoNotOptimize(pairs.data());
+        });
+    }
+    state.SetItemsProcessed(state.iterations() * (2 * index + 1));
+}
+
+// Benchmark hill climbing with a parsimony loss (50 leaves, 500 sites)
+// until a pass does not improve
+// Arguments: number of threads
+static void BM_hillClimbingParsimony(benchmark::State &state) {
+    const size_t numLeaves = 50;
+    std::mt19937 gen(42);
+    std::vector<std::string> sequences(numLeaves);
+    for (auto &sequence : sequences) {
+        for (size_t s = 0; s < 500; ++s) {
+            sequence += "ACGT"[gen() % 4];
+        }
+    }
+    TreeLoss loss = makeParsimonyLoss(sequences);
+    PhyloVec v = sample(numLeaves, false, 42);
+
+    HillClimbingOptions options;
+    options.patience = 1;
+    options.numThreads = state.range(0);
+    for (auto _ : state) {
+        HillClimbingResult result = hillClimbing(v, loss, options);
+        benchmark::DoNotOptimize(result.v.data());
+        state.counters["evaluations"] = result.numEvaluations;
+    }
+}
+
+// Benchmark reorderBirthDeath with shuffled children
+static void BM_reorderBirthDeath(benchmark::State &state) {
+    int n = state.range(0);
+    PhyloVec v = sample(n, false);
+    Leaf2Taxon mapping(n, "taxon");
+    CounterRNG rng(42);
+    for (auto _ : state) {
+        reorderBirthDeath(v, mapping, rng);
+        benchmark::DoNotOptimize(v.data());
+    }
+}
+
+// Benchmark rerootAtRandom
+static void BM_rerootAtRandom(benchmark::State &state) {
+    int n = state.range(0);
+    PhyloVec v = sample(n, false);
+    CounterRNG rng(42);
+    for (auto _ : state) {
+        rerootAtRandom(v, rng);
+        benchmark::DoNotOptimize(v.data());
+    }
+}
+
+// Benchmark moving a random leaf (removeLeaf then addLeaf on a vector)
+static void BM_removeAddLeaf(benchmark::State &state) {
+    int n = state.range(0);
+    PhyloVec v = sample(n, false);
+    std::mt19937 gen(42);
+    for (auto _ : state) {
+        unsigned int leaf = gen() % n;
+        removeLeaf(v, leaf);
+        addLeaf(v, leaf, gen() % (n - 1));
+        benchmark::DoNotOptimize(v.data());
+    }
+}
+
+// Benchmark moving a random leaf in a DynamicTree, then fetching the changed suffix
+// Arguments: number of leaves, whether to fetch the suffix,
+// branches drawn (0 = pendant branches of leaves, 1 = internal branches, 2 = any branch)
+static void BM_dynamicTreeRemoveAddLeaf(benchmark::State &state) {
+    int n = state.range(0);
+    DynamicTree tree(sample(n, false));
+    std::mt19937 gen(42);
+    PhyloVec suffix;
+
+    // After the removal, branches [0, n - 1) lead to leaves and [n - 1, 2n - 3) are internal
+    const unsigned int numBranches[] = {unsigned(n - 1), unsigned(n - 2), unsigned(2 * n - 3)};
+    const unsigned int firstBranch[] = {0, unsigned(n - 1), 0};
+    const int kind = state.range(2);
+
+    for (auto _ : state) {
+        unsigned int leaf = gen() % n;
+        tree.removeLeaf(leaf);
+        tree.addLeaf(leaf, firstBranch[kind] + gen() % numBranches[kind]);
+        if (state.range(1)) {
+            tree.getChangedSuffix(suffix);
+        }
+        benchmark::DoNotOptimize(suffix.data());
+    }
+}
+
+// Benchmark getCherries (parsing only) on a fixed Newick string
+static void BM_getCherries(benchmark::State &state) {
+    int n = state.range(0);
+    std::string newick = toNewick(sample(n, false));
+    for (auto _ : state) {
+        Ancestry cherries = getCherries(newick);
+        benchmark::DoNotOptimize(cherries);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * newick.size());
+}
+
+// Benchmark getCherriesNoParents (parsing only) on a fixed Newick string
+static void BM_getCherriesNoParents(benchmark::State &state) {
+    int n = state.range(0);
+    std::string newick = toNewick(sample(n, false), false);
+    for (auto _ : state) {
+        Ancestry cherries = getCherriesNoParents(newick);
+        benchmark::DoNotOptimize(cherries);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * newick.size());
 }
 
 #define QUICK_RANGE Range(8 << 6, 8 << 12)->Unit(benchmark::kMillisecond)
 #define BIG_RANGE DenseRange(10000, 100000, 10000)->Unit(benchmark::kMillisecond)
+#define BATCH_RANGE                                                                              \
+    ArgsProduct({{10000, 100000}, {1, 2, 4, 8, 16, 32}})                                         \
+        ->UseRealTime()                                                                          \
+        ->Unit(benchmark::kMillisecond)
 
 BENCHMARK(BM_sample)->BIG_RANGE;
+BENCHMARK(BM_sampleMany)->BIG_RANGE;
+BENCHMARK(BM_getPairs)->BIG_RANGE;
+BENCHMARK(BM_getPairsReuse)->BIG_RANGE;
 BENCHMARK(BM_toNewick)->BIG_RANGE;
+BENCHMARK(BM_toNewickReuse)->BIG_RANGE;
+BENCHMARK(BM_toNewickWorkspace)->BIG_RANGE;
+BENCHMARK(BM_toNewickStream)->BIG_RANGE;
+BENCHMARK(BM_getCherries)->BIG_RANGE;
+BENCHMARK(BM_getCherriesNoParents)->BIG_RANGE;
 BENCHMARK(BM_toVector)->BIG_RANGE;
+BENCHMARK(BM_toVectorWorkspace)->BIG_RANGE;
 BENCHMARK(BM_toVectorNoParents)->BIG_RANGE;
+BENCHMARK_TEMPLATE(BM_toMatrix, float, BranchLayout::AoS)->BIG_RANGE;
+BENCHMARK_TEMPLATE(BM_toMatrix, double, BranchLayout::SoA)->BIG_RANGE;
+BENCHMARK_TEMPLATE(BM_toMatrix, Half, BranchLayout::AoS)->BIG_RANGE;
+BENCHMARK(BM_toMatrixNoParents)->BIG_RANGE;
+BENCHMARK(BM_toNewickWithBranches)
+    ->ArgsProduct({benchmark::CreateDenseRange(10000, 100000, 10000), {SHORTEST_PRECISION, 6}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_toNewickBatch)->BATCH_RANGE;
+BENCHMARK(BM_toVectorBatch)->BATCH_RANGE;
+BENCHMARK(BM_readTreeFile)->BATCH_RANGE;
+BENCHMARK(BM_packVector)->BIG_RANGE;
+BENCHMARK(BM_unpackVector)->BIG_RANGE;
+BENCHMARK(BM_robinsonFouldsAllPairs)
+    ->ArgsProduct({{1000, 2000}, {20, 100000}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_kendallColijnAllPairs)
+    ->RangeMultiplier(2)
+    ->Range(100, 400)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_shapeStatsBatch)
+    ->ArgsProduct({{0, 1}, {1, 4}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_treeIndex)->BIG_RANGE;
+BENCHMARK(BM_treeIndexDistanceBatch)
+    ->ArgsProduct({{10000, 100000, 1000000}, {1, 4}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_neighbourhoodNaive)->Arg(1000)->Arg(2000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_neighbourhood)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_hillClimbingParsimony)
+    ->Arg(1)
+    ->Arg(4)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_reorderBirthDeath)->BIG_RANGE;
+BENCHMARK(BM_rerootAtRandom)->BIG_RANGE;
+BENCHMARK(BM_removeAddLeaf)->Arg(50000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_dynamicTreeRemoveAddLeaf)->ArgsProduct({{50000}, {0, 1}, {0, 1, 2}});
+BENCHMARK(BM_copheneticDistances)->DenseRange(5000, 20000, 5000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_patristicDistances)->DenseRange(5000, 20000, 5000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_writeCopheneticDistances)
+    ->DenseRange(10000, 40000, 10000)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
 
 // Run the benchmark
 BENCHMARK_MAIN();
\ No newline at end of file
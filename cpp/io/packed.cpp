@@ -0,0 +1,163 @@
+#include "packed.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+#include "../ops/vector.hpp"
+#include "../utils/parallel.hpp"
+
+const char PACKED_MAGIC[8] = {'P', '2', 'V', 'P', 'A', 'C', 'K', '\0'};
+
+// Number of records packed in memory before being written
+const size_t PACKED_BLOCK_SIZE = 4096;
+
+size_t getPackedRecordSize(size_t numLeaves) {
+    size_t numBits = 0;
+    for (size_t i = 1; i + 1 < numLeaves; ++i) {
+        numBits += getPackedWidth(i);
+    }
+    // Round up to whole 64-bit words
+    return (numBits + 63) / 64 * 8;
+}
+
+void packVector(const PhyloVec &v, char *record) {
+    uint64_t word = 0;
+    unsigned int filled = 0;
+    unsigned int width = 1;
+
+    for (size_t i = 1; i < v.size(); ++i) {
+        // The width of 2i grows by one bit at each power of two
+        if ((i & (i - 1)) == 0) {
+            ++width;
+        }
+
+        const uint64_t value = v[i];
+        word |= value << filled;
+        filled += width;
+
+        if (filled >= 64) {
+            std::memcpy(record, &word, 8);
+            record += 8;
+            filled -= 64;
+            // High bits of value which did not fit in the previous word
+            word = filled > 0 ? value >> (width - filled) : 0;
+        }
+    }
+
+    if (filled > 0) {
+        std::memcpy(record, &word, 8);
+    }
+}
+
+void unpackVector(const char *record, size_t numLeaves, PhyloVec &v) {
+    v.resize(numLeaves - 1);
+    if (v.empty()) {
+        return;
+    }
+    v[0] = 0;
+
+    // Bits of the current word which have not been consumed
+    uint64_t word = 0;
+    unsigned int available = 0;
+    unsigned int width = 1;
+
+    for (size_t i = 1; i < v.size(); ++i) {
+        if ((i & (i - 1)) == 0) {
+            ++width;
+        }
+        const uint64_t mask = (uint64_t(1) << width) - 1;
+
+        if (available >= width) {
+            v[i] = word & mask;
+            word >>= width;
+            available -= width;
+        } else {
+            // The entry straddles two words
+            uint64_t next;
+            std::memcpy(&next, record, 8);
+            record += 8;
+
+            v[i] = (word | (next << available)) & mask;
+            word = next >> (width - available);
+            available = 64 - (width - available);
+        }
+    }
+}
+
+void writePackedVectors(const std::string &path, const std::vector<PhyloVec> &vs,
+                        unsigned int numThreads) {
+    const size_t numLeaves = vs.empty() ? 1 : vs[0].size() + 1;
+
+    for (const auto &v : vs) {
+        if (v.size() + 1 != numLeaves) {
+            throw std::invalid_argument("All vectors must have the same number of leaves.");
+        }
+        check_v(v);
+    }
+
+    PackedHeader header;
+    std::memcpy(header.magic, PACKED_MAGIC, sizeof(PACKED_MAGIC));
+    header.version = PACKED_FORMAT_VERSION;
+    header.numLeaves = numLeaves;
+    header.count = vs.size();
+    header.recordSize = getPackedRecordSize(numLeaves);
+
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    std::vector<char> block(std::min(vs.size(), PACKED_BLOCK_SIZE) * header.recordSize);
+    for (size_t start = 0; start < vs.size(); start += PACKED_BLOCK_SIZE) {
+        const size_t blockCount = std::min(PACKED_BLOCK_SIZE, vs.size() - start);
+
+        std::fill(block.begin(), block.end(), 0);
+        parallelFor(
+            blockCount, numThreads,
+            [&](size_t i, unsigned int) {
+                packVector(vs[start + i], block.data() + i * header.recordSize);
+            },
+            64);
+
+        out.write(block.data(), blockCount * header.recordSize);
+    }
+
+    if (!out) {
+        throw std::system_error(errno, std::generic_category(), "Cannot write " + path);
+    }
+}
+
+PackedVectorFile::PackedVectorFile(const std::string &path) : file(path) {
+    if (file.size() < sizeof(PackedHeader)) {
+        throw std::invalid_argument("Invalid packed vector file: " + path);
+    }
+    std::memcpy(&header, file.data(), sizeof(PackedHeader));
+
+    if (std::memcmp(header.magic, PACKED_MAGIC, sizeof(PACKED_MAGIC)) != 0) {
+        throw std::invalid_argument("Invalid packed vector file: " + path);
+    }
+    if (header.version != PACKED_FORMAT_VERSION) {
+        throw std::invalid_argument("Unsupported packed vector file version: " +
+                                    std::to_string(header.version));
+    }
+    if (header.numLeaves == 0 || header.recordSize != getPackedRecordSize(header.numLeaves) ||
+        file.size() != sizeof(PackedHeader) + header.count * header.recordSize) {
+        throw std::invalid_argument("Invalid packed vector file: " + path);
+    }
+}
+
+PhyloVec PackedVectorFile::get(size_t i) const {
+    PhyloVec v;
+    get(i, v);
+    return v;
+}
+
+void PackedVectorFile::get(size_t i, PhyloVec &v) const {
+    if (i >= header.count) {
+        throw std::out_of_range("Index " + std::to_string(i) + " out of range for " +
+                                std::to_string(header.count) + " vectors.");
+    }
+    unpackVector(file.data() + sizeof(PackedHeader) + i * header.recordSize, header.numLeaves, v);
+}
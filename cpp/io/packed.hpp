@@ -0,0 +1,130 @@
+#ifndef PACKED_HPP
+#define PACKED_HPP
+
+/**
+ * @file packed.hpp
+ * @brief Bit-packed binary storage of Phylo2Vec vectors
+ *
+ * As 0 <= v[i] <= 2i, entry i only needs bitWidth(2i) bits
+ * (e.g., ~17 bits for a tree with 100k leaves instead of 32).
+ *
+ * File layout (in the byte order of the host that wrote it,
+ * i.e. little-endian on x86-64 and ARM64; a file written on a host of the other
+ * byte order is rejected, as its version does not match):
+ * - header (32 bytes): magic "P2VPACK", format version, number of leaves,
+ *   number of vectors, size of a record in bytes
+ * - one record per vector: entries 1..n-2 packed LSB-first
+ *   (v[0] = 0 is not stored), zero-padded to a multiple of 8 bytes.
+ * All vectors of a file have the same number of leaves,
+ * so records have a fixed size and record k starts at 32 + k * recordSize
+ * (O(1) random access without an explicit index).
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../base/core.hpp"
+#include "../utils/mapped_file.hpp"
+
+inline constexpr uint32_t PACKED_FORMAT_VERSION = 1;
+
+/**
+ * @brief Header of a packed vector file
+ */
+struct PackedHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t numLeaves;
+    uint64_t count;
+    uint64_t recordSize;
+};
+
+static_assert(sizeof(PackedHeader) == 32, "PackedHeader must be 32 bytes");
+
+/**
+ * @brief Number of bits used to store v[i]
+ * @param i index in the vector
+ * @return unsigned int bit width of 2i
+ */
+inline unsigned int getPackedWidth(size_t i) {
+    unsigned int width = 0;
+    for (size_t x = 2 * i; x > 0; x >>= 1) {
+        ++width;
+    }
+    return width;
+}
+
+/**
+ * @brief Size in bytes of a packed record of a tree with numLeaves leaves
+ * @param numLeaves number of leaves
+ * @return size_t record size (multiple of 8)
+ */
+size_t getPackedRecordSize(size_t numLeaves);
+
+/**
+ * @brief Pack a vector into a record
+ * @param v Phylo2Vec vector (v[i] <= 2i is assumed, see check_v)
+ * @param record output buffer of getPackedRecordSize(v.size() + 1) bytes
+ */
+void packVector(const PhyloVec &v, char *record);
+
+/**
+ * @brief Unpack a vector from a record
+ * @param record packed record
+ * @param numLeaves number of leaves of the tree
+ * @param v output vector (overwritten)
+ */
+void unpackVector(const char *record, size_t numLeaves, PhyloVec &v);
+
+/**
+ * @brief Write vectors to a packed vector file
+ * @param path output path
+ * @param vs vectors, all with the same number of leaves
+ * @param numThreads number of threads used to pack the records (0 = all hardware threads)
+ */
+void writePackedVectors(const std::string &path, const std::vector<PhyloVec> &vs,
+                        unsigned int numThreads = 0);
+
+/**
+ * @brief Memory-mapped packed vector file
+ * Vectors are decoded on demand.
+ */
+class PackedVectorFile {
+   public:
+    /**
+     * @brief Map a packed vector file
+     * @param path path to the file
+     * @throws std::invalid_argument if the file is not a valid packed vector file
+     */
+    explicit PackedVectorFile(const std::string &path);
+
+    /**
+     * @brief Number of vectors in the file
+     */
+    size_t size() const { return header.count; }
+
+    /**
+     * @brief Number of leaves of each tree in the file
+     */
+    size_t getNumLeaves() const { return header.numLeaves; }
+
+    /**
+     * @brief Decode vector i
+     * @throws std::out_of_range if i >= size()
+     */
+    PhyloVec get(size_t i) const;
+
+    /**
+     * @brief Decode vector i into an existing vector
+     * @throws std::out_of_range if i >= size()
+     */
+    void get(size_t i, PhyloVec &v) const;
+
+   private:
+    MappedFile file;
+
+    PackedHeader header;
+};
+
+#endif  // PACKED_HPP
@@ -0,0 +1,131 @@
+#include "tree_file.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+#include "../base/to_vector.hpp"
+#include "../ops/newick.hpp"
+#include "../utils/parallel.hpp"
+
+// Minimum size of a block of text searched by one thread
+const size_t MIN_BLOCK_SIZE = 1 << 20;
+
+std::vector<std::string_view> splitTrees(std::string_view text, unsigned int numThreads) {
+    numThreads = getNumThreads(numThreads);
+
+    const size_t blockSize = std::max(text.size() / numThreads + 1, MIN_BLOCK_SIZE);
+    const size_t numBlocks = (text.size() + blockSize - 1) / blockSize;
+
+    // Positions of the line breaks in each block
+    std::vector<std::vector<size_t>> lineBreaks(numBlocks);
+
+    parallelFor(numBlocks, numThreads, [&](size_t b, unsigned int) {
+        const char *start = text.data();
+        const char *ptr = start + b * blockSize;
+        const char *end = start + std::min((b + 1) * blockSize, text.size());
+        while ((ptr = static_cast<const char *>(std::memchr(ptr, '\n', end - ptr))) != nullptr) {
+            lineBreaks[b].push_back(ptr - start);
+            ++ptr;
+        }
+    });
+
+    std::vector<std::string_view> trees;
+
+    size_t lineStart = 0;
+    auto addLine = [&](size_t lineEnd) {
+        std::string_view line = text.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string_view::npos) {
+            return;
+        }
+        size_t last = line.find_last_not_of(" \t\r");
+        trees.push_back(line.substr(first, last - first + 1));
+    };
+
+    for (const auto &block : lineBreaks) {
+        for (size_t lineEnd : block) {
+            addLine(lineEnd);
+        }
+    }
+    if (lineStart < text.size()) {
+        addLine(text.size());
+    }
+
+    return trees;
+}
+
+VectorCollection toVectorCollection(const std::vector<std::string_view> &newicks,
+                                    NewickLabels labels, unsigned int numThreads) {
+    numThreads = getNumThreads(numThreads);
+
+    const size_t count = newicks.size();
+
+    VectorCollection result;
+
+    // A binary tree has one closing bracket per cherry,
+    // i.e. per entry of its vector
+    result.offsets.assign(count + 1, 0);
+    parallelFor(
+        count, numThreads,
+        [&](size_t i, unsigned int) {
+            result.offsets[i + 1] = std::count(newicks[i].begin(), newicks[i].end(), ')');
+        },
+        64);
+    std::partial_sum(result.offsets.begin(), result.offsets.end(), result.offsets.begin());
+
+    result.data.resize(result.offsets.back());
+    if (labels == NewickLabels::Taxa) {
+        result.taxa.resize(count);
+    }
+
+    // Per-thread scratch space
+    std::vector<ConversionWorkspace> workspaces(numThreads);
+    std::vector<PhyloVec> vs(numThreads);
+
+    parallelFor(count, numThreads, [&](size_t i, unsigned int t) {
+        PhyloVec &v = vs[t];
+
+        switch (labels) {
+            case NewickLabels::Parents:
+                toVector(newicks[i], v, workspaces[t]);
+                break;
+            case NewickLabels::NoParents:
+                toVectorNoParents(newicks[i], v, workspaces[t]);
+                break;
+            case NewickLabels::Taxa: {
+                Converter converter = toIntNewick(newicks[i]);
+                removeBranchAnnotations(converter.intNewick);
+                removeParentLabels(converter.intNewick);
+
+                toVectorNoParents(converter.intNewick, v, workspaces[t]);
+
+                // Leaf taxa keep their branch lengths in the mapping
+                for (auto &taxon : converter.mapping) {
+                    taxon = taxon.substr(0, taxon.find(':'));
+                }
+                result.taxa[i] = std::move(converter.mapping);
+                break;
+            }
+        }
+
+        if (v.size() != result.offsets[i + 1] - result.offsets[i]) {
+            std::ostringstream oss;
+            oss << "Invalid tree at index " << i << ": not a binary tree";
+            throw std::invalid_argument(oss.str());
+        }
+
+        std::copy(v.begin(), v.end(), result.data.begin() + result.offsets[i]);
+    });
+
+    return result;
+}
+
+VectorCollection readTreeFile(const MappedFile &file, NewickLabels labels,
+                              unsigned int numThreads) {
+    return toVectorCollection(splitTrees(file.view(), numThreads), labels, numThreads);
+}
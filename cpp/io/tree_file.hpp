@@ -0,0 +1,74 @@
+#ifndef TREE_FILE_HPP
+#define TREE_FILE_HPP
+
+/**
+ * @file tree_file.hpp
+ * @brief Parallel conversion of multi-tree files (one Newick per line) to vectors
+ */
+
+#include <string_view>
+#include <vector>
+
+#include "../base/core.hpp"
+#include "../utils/mapped_file.hpp"
+
+/**
+ * @brief Labelling of the Newick strings in a multi-tree file
+ */
+enum class NewickLabels {
+    // Integer leaves with parent labels, as output by toNewick(v)
+    Parents,
+    // Integer leaves without parent labels, as output by toNewick(v, false)
+    NoParents,
+    // String taxa, optionally with branch lengths and internal node labels
+    Taxa,
+};
+
+/**
+ * @brief Vectors of many trees stored contiguously
+ * Vector i is data[offsets[i]:offsets[i + 1]]
+ */
+struct VectorCollection {
+    PhyloVec data;
+    std::vector<size_t> offsets;
+    // Only filled for NewickLabels::Taxa: taxa[i][leaf] = taxon of the leaf in tree i
+    // (views into the Newick strings, without branch lengths)
+    std::vector<Leaf2Taxon> taxa;
+};
+
+/**
+ * @brief Split a multi-tree text into trees (one per non-empty line), without copying
+ * Line boundaries are searched in parallel over blocks of the text.
+ * Leading and trailing whitespace is stripped from each tree.
+ * @param text multi-tree text (e.g., MappedFile::view())
+ * @param numThreads number of threads (0 = all hardware threads)
+ * @return std::vector<std::string_view> trees, in file order
+ */
+std::vector<std::string_view> splitTrees(std::string_view text, unsigned int numThreads = 0);
+
+/**
+ * @brief Convert many Newick strings to vectors in parallel, into a contiguous output
+ * Each thread reuses its own conversion workspace.
+ * @param newicks Newick strings
+ * @param labels labelling of the Newick strings
+ * @param numThreads number of threads (0 = all hardware threads)
+ * @return VectorCollection vectors, in input order
+ */
+VectorCollection toVectorCollection(const std::vector<std::string_view> &newicks,
+                                    NewickLabels labels = NewickLabels::Parents,
+                                    unsigned int numThreads = 0);
+
+/**
+ * @brief Convert all trees of a memory-mapped multi-tree file to vectors
+ * The tree text is read in place: the file is never copied.
+ * With NewickLabels::Taxa, the taxa are views into the file,
+ * so they are only valid while the file is mapped.
+ * @param file memory-mapped file with one Newick per line
+ * @param labels labelling of the Newick strings
+ * @param numThreads number of threads (0 = all hardware threads)
+ * @return VectorCollection vectors, in file order
+ */
+VectorCollection readTreeFile(const MappedFile &file, NewickLabels labels = NewickLabels::Parents,
+                              unsigned int numThreads = 0);
+
+#endif  // TREE_FILE_HPP
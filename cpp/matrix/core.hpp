@@ -7,11 +7,126 @@
  */
 
 #include <array>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 
-struct PhyloMat {
+#include "../base/core.hpp"
+#include "../utils/half.hpp"
+
+/**
+ * @brief Memory layout of the branch lengths of a Phylo2Mat matrix
+ * AoS: one {branch1, branch2} pair per cherry
+ * SoA: one column per child, so that kernels can vectorise over each column
+ */
+enum class BranchLayout { AoS, SoA };
+
+/**
+ * @brief Branch lengths in the SoA layout
+ * left[i], right[i]: branch lengths of the first and second child of cherry i
+ */
+template <typename T>
+struct BranchColumns {
+    std::vector<T> left;
+    std::vector<T> right;
+
+    size_t size() const { return left.size(); }
+
+    void resize(size_t n) {
+        left.resize(n);
+        right.resize(n);
+    }
+
+    std::array<T, 2> operator[](size_t i) const { return {left[i], right[i]}; }
+
+    bool operator==(const BranchColumns &other) const {
+        return left == other.left && right == other.right;
+    }
+};
+
+/**
+ * @brief Phylo2Mat matrix
+ * v: Phylo2Vec vector
+ * branches[i]: branch lengths of the two children of cherry i in the ancestry
+ * @tparam T branch length type (float, double or Half)
+ * @tparam Layout memory layout of the branch lengths
+ */
+template <typename T, BranchLayout Layout = BranchLayout::AoS>
+struct BasicPhyloMat {
+    typedef T Scalar;
+
+    typedef std::conditional_t<Layout == BranchLayout::AoS, std::vector<std::array<T, 2>>,
+                               BranchColumns<T>>
+        Branches;
+
     PhyloVec v;
-    std::vector<std::array<float, 2>> branches;
+    Branches branches;
 };
 
-#endif // MATRIX_CORE_HPP
\ No newline at end of file
+typedef BasicPhyloMat<float> PhyloMat;
+
+/**
+ * @brief Check that a matrix has the branch lengths of one cherry per entry of its vector
+ * @throws std::invalid_argument otherwise
+ */
+template <typename T, BranchLayout Layout>
+void checkBranches(const BasicPhyloMat<T, Layout> &m) {
+    if (m.branches.size() != m.v.size()) {
+        std::ostringstream oss;
+        oss << "Expected " << m.v.size() << " rows of branch lengths (got " << m.branches.size()
+            << ")";
+        throw std::invalid_argument(oss.str());
+    }
+}
+
+/**
+ * @brief Type in which branch lengths of type T are parsed, printed and computed
+ * (float for Half, T otherwise)
+ */
+template <typename T>
+using ArithmeticType = std::conditional_t<std::is_same_v<T, Half>, float, T>;
+
+/**
+ * @brief Set the branch lengths of cherry i (in either layout)
+ */
+template <typename T>
+void setBranches(std::vector<std::array<T, 2>> &branches, size_t i, const std::array<T, 2> &b) {
+    branches[i] = b;
+}
+
+template <typename T>
+void setBranches(BranchColumns<T> &branches, size_t i, const std::array<T, 2> &b) {
+    branches.left[i] = b[0];
+    branches.right[i] = b[1];
+}
+
+/**
+ * @brief Convert a matrix to another branch length type and/or layout, in bulk
+ * e.g., ```BasicPhyloMat<Half> archived = convertMatrix<Half>(m);```
+ * @tparam U output branch length type
+ * @tparam OutLayout output layout
+ * @param m input matrix
+ * @return BasicPhyloMat<U, OutLayout> converted matrix
+ */
+template <typename U, BranchLayout OutLayout = BranchLayout::AoS, typename T,
+          BranchLayout InLayout>
+BasicPhyloMat<U, OutLayout> convertMatrix(const BasicPhyloMat<T, InLayout> &m) {
+    BasicPhyloMat<U, OutLayout> result;
+    result.v = m.v;
+
+    const size_t numCherries = m.branches.size();
+    result.branches.resize(numCherries);
+
+    // Convert through the arithmetic type (Half only converts from/to float)
+    auto convert = [](T x) { return U(ArithmeticType<U>(ArithmeticType<T>(x))); };
+
+    for (size_t i = 0; i < numCherries; ++i) {
+        std::array<T, 2> b = m.branches[i];
+        setBranches(result.branches, i, {convert(b[0]), convert(b[1])});
+    }
+
+    return result;
+}
+
+#endif // MATRIX_CORE_HPP
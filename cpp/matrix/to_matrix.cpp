@@ -0,0 +1,300 @@
+#include "to_matrix.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include <string>
+
+#include "../base/to_vector.hpp"
+
+// Parse the branch length annotation (":<length>") following newick[i]
+// as a P (float or double) and move i to its last char
+// Returns false if newick[i] is not followed by a branch length
+template <typename P>
+static bool parseBranchLength(std::string_view newick, size_t &i, double &length) {
+    if (i + 1 >= newick.length() || newick[i + 1] != ':') {
+        return false;
+    }
+
+    const char *first = newick.data() + i + 2;
+    const char *last = newick.data() + newick.length();
+
+    P value;
+    auto [ptr, ec] = std::from_chars(first, last, value);
+    if (ec != std::errc()) {
+        throw std::invalid_argument("Invalid branch length at position " + std::to_string(i + 2));
+    }
+    length = value;
+
+    i = ptr - newick.data() - 1;
+
+    return true;
+}
+
+// Convert a parsed branch length to T
+template <typename T>
+static T toBranch(double length) {
+    return T(ArithmeticType<T>(length));
+}
+
+// Parse the cherries and the (unordered) branch lengths into ws.branches
+template <typename P>
+static void parseCherriesAndBranches(std::string_view newick, Ancestry &cherries,
+                                     ConversionWorkspace &ws) {
+    std::vector<std::array<double, 2>> &branches = ws.branches;
+
+    // A binary tree has one cherry per closing bracket
+    const size_t numCherries = std::count(newick.begin(), newick.end(), ')');
+
+    cherries.clear();
+    cherries.reserve(numCherries);
+    branches.clear();
+    branches.reserve(numCherries);
+
+    // Stack of nodes and stack of the branch lengths above them
+    std::vector<int> &stack = ws.nodeStack;
+    stack.clear();
+    stack.reserve(numCherries + 1);
+
+    std::vector<double> &branchStack = ws.branchStack;
+    branchStack.clear();
+    branchStack.reserve(numCherries + 1);
+
+    for (size_t i = 0; i < newick.length(); ++i) {
+        char c = newick[i];
+        if (c == ')') {
+            ++i;
+
+            // Pop the children nodes and their branch lengths from the stacks
+            int c2 = stack.back();
+            stack.pop_back();
+            int c1 = stack.back();
+            stack.pop_back();
+
+            double b2 = branchStack.back();
+            branchStack.pop_back();
+            double b1 = branchStack.back();
+            branchStack.pop_back();
+
+            // Get the parent node after )
+            int p = parseLabel(newick, i);
+            if (p == -1) {
+                throw std::invalid_argument("Missing parent label at position " +
+                                            std::to_string(i));
+            }
+
+            // Add the triplet (c1, c2, p) and its branch lengths
+            cherries.push_back({c1, c2, p});
+            branches.push_back({b1, b2});
+
+            // Push the parent node and its branch length to the stacks
+            // (the root has no branch length)
+            double bp;
+            if (parseBranchLength<P>(newick, i, bp)) {
+                stack.push_back(p);
+                branchStack.push_back(bp);
+            } else if (!stack.empty()) {
+                throw std::invalid_argument("Missing branch length at position " +
+                                            std::to_string(i + 1));
+            }
+        } else if (c >= '0' && c <= '9') {
+            // Get the next node and its branch length and push them to the stacks
+            int node = parseLabel(newick, i);
+
+            double bn;
+            if (!parseBranchLength<P>(newick, i, bn)) {
+                throw std::invalid_argument("Missing branch length at position " +
+                                            std::to_string(i + 1));
+            }
+
+            stack.push_back(node);
+            branchStack.push_back(bn);
+        }
+    }
+}
+
+// Parse the cherries and the (unordered) branch lengths into ws.branches
+template <typename P>
+static void parseCherriesAndBranchesNoParents(std::string_view newick, Ancestry &cherries,
+                                              ConversionWorkspace &ws) {
+    std::vector<std::array<double, 2>> &branches = ws.branches;
+
+    const size_t numCherries = std::count(newick.begin(), newick.end(), ')');
+
+    cherries.clear();
+    cherries.reserve(numCherries);
+    branches.clear();
+    branches.reserve(numCherries);
+
+    std::vector<int> &stack = ws.nodeStack;
+    stack.clear();
+    stack.reserve(numCherries + 1);
+
+    std::vector<double> &branchStack = ws.branchStack;
+    branchStack.clear();
+    branchStack.reserve(numCherries + 1);
+
+    for (size_t i = 0; i < newick.length(); ++i) {
+        char c = newick[i];
+        if (c == ')') {
+            // Pop the children nodes and their branch lengths from the stacks
+            int c2 = stack.back();
+            stack.pop_back();
+            int c1 = stack.back();
+            stack.pop_back();
+
+            double b2 = branchStack.back();
+            branchStack.pop_back();
+            double b1 = branchStack.back();
+            branchStack.pop_back();
+
+            // No parent annotation --> store the max leaf
+            cherries.push_back({c1, c2, std::max(c1, c2)});
+            branches.push_back({b1, b2});
+
+            // Push the min leaf and the parent branch length to the stacks
+            // (the root has no branch length)
+            double bp;
+            if (parseBranchLength<P>(newick, i, bp)) {
+                stack.push_back(std::min(c1, c2));
+                branchStack.push_back(bp);
+            } else if (!stack.empty()) {
+                throw std::invalid_argument("Missing branch length at position " +
+                                            std::to_string(i + 1));
+            }
+        } else if (c >= '0' && c <= '9') {
+            // Get the next leaf and its branch length and push them to the stacks
+            int leaf = parseLabel(newick, i);
+
+            double bl;
+            if (!parseBranchLength<P>(newick, i, bl)) {
+                throw std::invalid_argument("Missing branch length at position " +
+                                            std::to_string(i + 1));
+            }
+
+            stack.push_back(leaf);
+            branchStack.push_back(bl);
+        }
+    }
+}
+
+template <typename T>
+std::pair<Ancestry, std::vector<std::array<T, 2>>> getCherriesAndBranches(std::string_view newick) {
+    ConversionWorkspace ws;
+    std::pair<Ancestry, std::vector<std::array<T, 2>>> result;
+    getCherriesAndBranches(newick, result.first, result.second, ws);
+    return result;
+}
+
+template <typename T>
+void getCherriesAndBranches(std::string_view newick, Ancestry &cherries,
+                            std::vector<std::array<T, 2>> &branches, ConversionWorkspace &ws) {
+    parseCherriesAndBranches<ArithmeticType<T>>(newick, cherries, ws);
+
+    branches.resize(ws.branches.size());
+    for (size_t i = 0; i < branches.size(); ++i) {
+        branches[i] = {toBranch<T>(ws.branches[i][0]), toBranch<T>(ws.branches[i][1])};
+    }
+}
+
+template <typename T>
+std::pair<Ancestry, std::vector<std::array<T, 2>>>
+getCherriesAndBranchesNoParents(std::string_view newick) {
+    ConversionWorkspace ws;
+    std::pair<Ancestry, std::vector<std::array<T, 2>>> result;
+    getCherriesAndBranchesNoParents(newick, result.first, result.second, ws);
+    return result;
+}
+
+template <typename T>
+void getCherriesAndBranchesNoParents(std::string_view newick, Ancestry &cherries,
+                                     std::vector<std::array<T, 2>> &branches,
+                                     ConversionWorkspace &ws) {
+    parseCherriesAndBranchesNoParents<ArithmeticType<T>>(newick, cherries, ws);
+
+    branches.resize(ws.branches.size());
+    for (size_t i = 0; i < branches.size(); ++i) {
+        branches[i] = {toBranch<T>(ws.branches[i][0]), toBranch<T>(ws.branches[i][1])};
+    }
+}
+
+// Reorder the parsed branch lengths like the cherries (ws.order) into the matrix
+template <typename T, BranchLayout Layout>
+static void gatherBranches(BasicPhyloMat<T, Layout> &m, const ConversionWorkspace &ws) {
+    m.branches.resize(ws.order.size());
+    for (size_t i = 0; i < ws.order.size(); ++i) {
+        const std::array<double, 2> &b = ws.branches[ws.order[i]];
+        setBranches(m.branches, i, {toBranch<T>(b[0]), toBranch<T>(b[1])});
+    }
+}
+
+template <typename T, BranchLayout Layout>
+BasicPhyloMat<T, Layout> toMatrix(std::string_view newick) {
+    ConversionWorkspace ws;
+    BasicPhyloMat<T, Layout> m;
+    toMatrix(newick, m, ws);
+    return m;
+}
+
+template <typename T, BranchLayout Layout>
+void toMatrix(std::string_view newick, BasicPhyloMat<T, Layout> &m, ConversionWorkspace &ws) {
+    parseCherriesAndBranches<ArithmeticType<T>>(newick, ws.ancestry, ws);
+
+    // Reorder the branch lengths like the cherries
+    orderCherries(ws.ancestry, ws.order, ws);
+    gatherBranches(m, ws);
+
+    buildVector(ws.ancestry, m.v, ws);
+}
+
+template <typename T, BranchLayout Layout>
+BasicPhyloMat<T, Layout> toMatrixNoParents(std::string_view newick) {
+    ConversionWorkspace ws;
+    BasicPhyloMat<T, Layout> m;
+    toMatrixNoParents(newick, m, ws);
+    return m;
+}
+
+template <typename T, BranchLayout Layout>
+void toMatrixNoParents(std::string_view newick, BasicPhyloMat<T, Layout> &m,
+                       ConversionWorkspace &ws) {
+    parseCherriesAndBranchesNoParents<ArithmeticType<T>>(newick, ws.ancestry, ws);
+
+    // Reorder the branch lengths like the cherries
+    orderCherriesNoParents(ws.ancestry, ws.order, ws);
+    gatherBranches(m, ws);
+
+    buildVector(ws.ancestry, m.v, ws);
+}
+
+// Explicit instantiations for the supported branch length types and layouts
+#define INSTANTIATE_CHERRIES_AND_BRANCHES(T)                                                      \
+    template std::pair<Ancestry, std::vector<std::array<T, 2>>> getCherriesAndBranches<T>(      \
+        std::string_view);                                                                       \
+    template void getCherriesAndBranches<T>(std::string_view, Ancestry &,                        \
+                                            std::vector<std::array<T, 2>> &,                     \
+                                            ConversionWorkspace &);                              \
+    template std::pair<Ancestry, std::vector<std::array<T, 2>>>                                  \
+    getCherriesAndBranchesNoParents<T>(std::string_view);                                        \
+    template void getCherriesAndBranchesNoParents<T>(std::string_view, Ancestry &,               \
+                                                     std::vector<std::array<T, 2>> &,            \
+                                                     ConversionWorkspace &);
+
+#define INSTANTIATE_TO_MATRIX(T, Layout)                                                          \
+    template BasicPhyloMat<T, Layout> toMatrix<T, Layout>(std::string_view);                     \
+    template void toMatrix<T, Layout>(std::string_view, BasicPhyloMat<T, Layout> &,              \
+                                      ConversionWorkspace &);                                    \
+    template BasicPhyloMat<T, Layout> toMatrixNoParents<T, Layout>(std::string_view);            \
+    template void toMatrixNoParents<T, Layout>(std::string_view, BasicPhyloMat<T, Layout> &,     \
+                                               ConversionWorkspace &);
+
+INSTANTIATE_CHERRIES_AND_BRANCHES(float)
+INSTANTIATE_CHERRIES_AND_BRANCHES(double)
+INSTANTIATE_CHERRIES_AND_BRANCHES(Half)
+
+INSTANTIATE_TO_MATRIX(float, BranchLayout::AoS)
+INSTANTIATE_TO_MATRIX(float, BranchLayout::SoA)
+INSTANTIATE_TO_MATRIX(double, BranchLayout::AoS)
+INSTANTIATE_TO_MATRIX(double, BranchLayout::SoA)
+INSTANTIATE_TO_MATRIX(Half, BranchLayout::AoS)
+INSTANTIATE_TO_MATRIX(Half, BranchLayout::SoA)
@@ -1,17 +1,98 @@
 #ifndef TO_MATRIX_HPP
 #define TO_MATRIX_HPP
 
+/**
+ * @file to_matrix.hpp
+ * @brief Newick-to-matrix conversion functions (Newick strings with branch lengths)
+ *
+ * Functions are templated on the branch length type T
+ * (instantiated for float, double and Half) and the layout of the output matrix.
+ * Branch lengths are parsed in ArithmeticType<T> (float for Half).
+ */
+
 #include "../base/core.hpp"
+#include "../base/workspace.hpp"
 #include "core.hpp"
 
-std::pair<Ancestry, std::vector<std::array<float, 2>>>
-getCherriesAndBranches(std::string_view newick);
+/**
+ * @brief Get all "cherries" and their branch lengths
+ * from a Newick string with parents and branch lengths
+ * Topology and branch lengths are parsed in a single pass.
+ *
+ * Example:
+ * ```std::string_view newick = ((0:0.1,1:0.2)4:0.6,(2:0.4,3:0.5)5:0.7)6;```
+ * cherries =
+ * 0 1 4
+ * 2 3 5
+ * 4 5 6
+ * branches =
+ * 0.1 0.2
+ * 0.4 0.5
+ * 0.6 0.7
+ * @param newick Newick string with parents and branch lengths
+ * @return pair of the ancestry {child1, child2, parent}
+ * and the branch lengths {branch1, branch2} of each cherry
+ */
+template <typename T = float>
+std::pair<Ancestry, std::vector<std::array<T, 2>>> getCherriesAndBranches(std::string_view newick);
+
+/**
+ * @brief getCherriesAndBranches into existing buffers, using the scratch space of a workspace
+ */
+template <typename T>
+void getCherriesAndBranches(std::string_view newick, Ancestry &cherries,
+                            std::vector<std::array<T, 2>> &branches, ConversionWorkspace &ws);
 
-std::pair<Ancestry, std::vector<std::array<float, 2>>>
+/**
+ * @brief Get all "cherries" and their branch lengths
+ * from a Newick string with branch lengths but without parent labels
+ * ```std::string_view newick = ((0:0.1,1:0.2):0.6,(2:0.4,3:0.5):0.7);```
+ * @param newick Newick string with branch lengths, without parent labels
+ * @return pair of the ancestry {child1, child2, max(child1, child2)}
+ * and the branch lengths {branch1, branch2} of each cherry
+ */
+template <typename T = float>
+std::pair<Ancestry, std::vector<std::array<T, 2>>>
 getCherriesAndBranchesNoParents(std::string_view newick);
 
-PhyloMat toMatrix(std::string_view newick);
+/**
+ * @brief getCherriesAndBranchesNoParents into existing buffers,
+ * using the scratch space of a workspace
+ */
+template <typename T>
+void getCherriesAndBranchesNoParents(std::string_view newick, Ancestry &cherries,
+                                     std::vector<std::array<T, 2>> &branches,
+                                     ConversionWorkspace &ws);
+
+/**
+ * @brief Convert a Newick string with parents and branch lengths to a matrix
+ * e.g., ```auto m = toMatrix<double, BranchLayout::SoA>(newick);```
+ * (a BasicPhyloMat<double, BranchLayout::SoA>)
+ * @param newick Newick string with parents and branch lengths
+ * @return BasicPhyloMat<T, Layout> matrix (PhyloMat by default)
+ */
+template <typename T = float, BranchLayout Layout = BranchLayout::AoS>
+BasicPhyloMat<T, Layout> toMatrix(std::string_view newick);
+
+/**
+ * @brief toMatrix into an existing matrix, using the scratch space of a workspace
+ */
+template <typename T, BranchLayout Layout>
+void toMatrix(std::string_view newick, BasicPhyloMat<T, Layout> &m, ConversionWorkspace &ws);
+
+/**
+ * @brief Convert a Newick string with branch lengths but without parent labels to a matrix
+ * @param newick Newick string with branch lengths, without parent labels
+ * @return BasicPhyloMat<T, Layout> matrix (PhyloMat by default)
+ */
+template <typename T = float, BranchLayout Layout = BranchLayout::AoS>
+BasicPhyloMat<T, Layout> toMatrixNoParents(std::string_view newick);
 
-PhyloMat toMatrixNoParents(std::string_view newick);
+/**
+ * @brief toMatrixNoParents into an existing matrix, using the scratch space of a workspace
+ */
+template <typename T, BranchLayout Layout>
+void toMatrixNoParents(std::string_view newick, BasicPhyloMat<T, Layout> &m,
+                       ConversionWorkspace &ws);
 
-#endif // TO_MATRIX_HPP
\ No newline at end of file
+#endif // TO_MATRIX_HPP
@@ -1,79 +1,153 @@
 #include "to_newick.hpp"
 
+#include <charconv>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
 #include "../base/to_newick.hpp"
 
-std::string
-buildNewickWithBranches(const Ancestry &ancestry,
-                        std::vector<std::array<float, 2>> branches) {
-    auto &[c1, c2, p] = ancestry.back();
-    auto &[b1, b2] = branches.back();
+// Marker for the closing bracket of an internal node on the writing stack
+const unsigned int CLOSE_BIT = 1u << 31;
+// Marker for a comma between two children on the writing stack
+const unsigned int COMMA = ~0u;
 
-    std::string c1Str = std::to_string(c1) + ":" + std::to_string(b1);
-    std::string c2Str = std::to_string(c2) + ":" + std::to_string(b2);
-    std::string pStr = std::to_string(p);
+template <typename T>
+size_t getMaxNewickWithBranchesLength(size_t numLeaves, int precision) {
+    typedef std::numeric_limits<ArithmeticType<T>> Limits;
 
-    // Initial Newick: (c1:b1, c2:b2)p;
-    std::string newick = "(" + c1Str + "," + c2Str + ")" + pStr + ";";
+    // Shortest: sign, max_digits10 digits, '.', exponent (e.g. -1.17549435e-38)
+    // Fixed: sign, integer digits, '.', decimals
+    const size_t maxFloatLength =
+        precision < 0 ? Limits::max_digits10 + 8 : Limits::max_exponent10 + 3 + precision;
 
-    // Max leaf number
-    const int leafMax = ancestry.size();
+    // Every node but the root has a branch length (':' + float)
+    const size_t numEdges = numLeaves > 0 ? 2 * numLeaves - 2 : 0;
 
-    // Queue of internal nodes
-    std::vector<int> parentQueue;
+    return getNewickLength(numLeaves, true) + numEdges * (1 + maxFloatLength);
+}
 
-    // Push nodes in the queue if they are internal
-    if (c1 > leafMax) {
-        parentQueue.push_back(c1);
-    }
-    if (c2 > leafMax) {
-        parentQueue.push_back(c2);
+template <typename Branches>
+std::string buildNewickWithBranches(const Ancestry &ancestry, const Branches &branches,
+                                    int precision) {
+    std::string newick;
+    buildNewickWithBranches(ancestry, branches, newick, precision);
+    return newick;
+}
+
+template <typename Branches>
+void buildNewickWithBranches(const Ancestry &ancestry, const Branches &branches,
+                             std::string &newick, int precision) {
+    // Branch length type and the type in which it is printed
+    typedef std::decay_t<decltype(branches[0][0])> T;
+    typedef ArithmeticType<T> P;
+
+    const unsigned int numCherries = ancestry.size();
+    const unsigned int numLeaves = numCherries + 1;
+
+    if (numCherries == 0) {
+        newick = "0;";
+        return;
     }
 
-    // position of nodes in the string
-    std::vector<int> nodeIdxs(2 * leafMax);
-    nodeIdxs[c1] = 1;
-    nodeIdxs[c2] = 2 + c1Str.length();
+    // Row of the ancestry where each internal node is the parent
+    std::vector<unsigned int> rows(numCherries);
+    for (unsigned int r = 0; r < numCherries; ++r) {
+        rows[ancestry[r][2] - numLeaves] = r;
+    }
 
-    for (int i = 1; i < leafMax; ++i) {
-        // Get the next internal node and pop it from the queue
-        int nextParent = parentQueue.back();
-        parentQueue.pop_back();
+    // Write into a buffer large enough for any branch length, then shrink it
+    newick.resize(getMaxNewickWithBranchesLength<T>(numLeaves, precision));
+    char *ptr = newick.data();
+    char *const end = ptr + newick.size();
+
+    auto putLabel = [&](unsigned int label) { ptr = std::to_chars(ptr, end, label).ptr; };
+
+    auto putBranch = [&](T value) {
+        P branch(value);
+        *ptr++ = ':';
+        std::to_chars_result result = precision < 0
+                                          ? std::to_chars(ptr, end, branch)
+                                          : std::to_chars(ptr, end, branch,
+                                                          std::chars_format::fixed, precision);
+        if (result.ec != std::errc()) {
+            throw std::logic_error("Newick buffer too small for a branch length");
+        }
+        ptr = result.ptr;
+    };
 
-        // Get the row corresponding to the nextParent
-        // Note that p == nextParent
-        auto &[c1, c2, p] = ancestry[nextParent - leafMax - 1];
+    // Pre-order traversal over edges: edge 2 * r + j leads to child j of row r
+    // (the root is reached by the virtual edge 2 * numCherries)
+    const unsigned int rootEdge = 2 * numCherries;
+    auto getNode = [&](unsigned int edge) -> unsigned int {
+        return edge == rootEdge ? ancestry.back()[2] : ancestry[edge >> 1][edge & 1];
+    };
 
-        auto &[b1, b2] = branches[nextParent - leafMax - 1];
+    std::vector<unsigned int> stack = {rootEdge};
 
-        // Convert the ints to strings
-        std::string c1Str = std::to_string(c1) + ":" + std::to_string(b1);
-        std::string c2Str = std::to_string(c2) + ":" + std::to_string(b2);
+    while (!stack.empty()) {
+        unsigned int edge = stack.back();
+        stack.pop_back();
 
-        // Insert a sub-newick (c1, c2) where the parent is
-        // Bef insert: old newick = (0,7)8; c1 = 6, c2 = 2, p = 7
-        newick.insert(nodeIdxs[p], "(" + c1Str + "," + c2Str + ")");
-        // Aft insert : new newick = (0,(6,2)7)8;
+        if (edge == COMMA) {
+            *ptr++ = ',';
+            continue;
+        }
 
-        // Update position of c1, c2 in the string
-        nodeIdxs[c1] = nodeIdxs[p] + 1;
-        nodeIdxs[c2] = nodeIdxs[c1] + c1Str.length() + 1;
+        bool close = edge & CLOSE_BIT;
+        edge &= ~CLOSE_BIT;
+        unsigned int node = getNode(edge);
+
+        if (node >= numLeaves && !close) {
+            // Open an internal node: write its children, then close it
+            unsigned int row = rows[node - numLeaves];
+            *ptr++ = '(';
+            stack.push_back(edge | CLOSE_BIT);
+            stack.push_back(2 * row + 1);
+            stack.push_back(COMMA);
+            stack.push_back(2 * row);
+            continue;
+        }
 
-        // Push nodes in the queue if they are internal
-        if (c1 > leafMax) {
-            parentQueue.push_back(c1);
+        if (close) {
+            *ptr++ = ')';
         }
-        if (c2 > leafMax) {
-            parentQueue.push_back(c2);
+        putLabel(node);
+        if (edge != rootEdge) {
+            putBranch(branches[edge >> 1][edge & 1]);
         }
     }
 
-    return newick;
+    *ptr++ = ';';
+
+    newick.resize(ptr - newick.data());
 }
 
-std::string toNewick(const PhyloMat &m) {
+template <typename T, BranchLayout Layout>
+std::string toNewick(const BasicPhyloMat<T, Layout> &m, int precision) {
+    checkBranches(m);
+
     Ancestry ancestry = getAncestry(m.v);
 
-    std::string newick = buildNewickWithBranches(ancestry, m.branches);
+    return buildNewickWithBranches(ancestry, m.branches, precision);
+}
 
-    return newick;
-}
\ No newline at end of file
+// Explicit instantiations for the supported branch length types and layouts
+#define INSTANTIATE_TO_NEWICK(T, Layout)                                                          \
+    template std::string buildNewickWithBranches(                                                \
+        const Ancestry &, const BasicPhyloMat<T, Layout>::Branches &, int);                      \
+    template void buildNewickWithBranches(const Ancestry &,                                      \
+                                          const BasicPhyloMat<T, Layout>::Branches &,            \
+                                          std::string &, int);                                   \
+    template std::string toNewick(const BasicPhyloMat<T, Layout> &, int);
+
+template size_t getMaxNewickWithBranchesLength<float>(size_t, int);
+template size_t getMaxNewickWithBranchesLength<double>(size_t, int);
+template size_t getMaxNewickWithBranchesLength<Half>(size_t, int);
+
+INSTANTIATE_TO_NEWICK(float, BranchLayout::AoS)
+INSTANTIATE_TO_NEWICK(float, BranchLayout::SoA)
+INSTANTIATE_TO_NEWICK(double, BranchLayout::AoS)
+INSTANTIATE_TO_NEWICK(double, BranchLayout::SoA)
+INSTANTIATE_TO_NEWICK(Half, BranchLayout::AoS)
+INSTANTIATE_TO_NEWICK(Half, BranchLayout::SoA)
@@ -1,12 +1,65 @@
 #ifndef MATRIX_TO_NEWICK_HPP
 #define MATRIX_TO_NEWICK_HPP
 
+/**
+ * @file to_newick.hpp
+ * @brief Matrix-to-Newick conversion functions (Newick strings with branch lengths)
+ *
+ * Functions are templated on the branch length type T
+ * (instantiated for float, double and Half) and the layout of the branch lengths.
+ * Branch lengths are printed as ArithmeticType<T> (float for Half).
+ */
+
 #include "../base/core.hpp"
 #include "core.hpp"
 
-std::string buildNewickWithBranches(const Ancestry &ancestry,
-                                    std::vector<std::array<float, 2>> branches);
+/**
+ * @brief Precision used to write the shortest representation of each branch length
+ * which parses back to the same value
+ */
+inline constexpr int SHORTEST_PRECISION = -1;
+
+/**
+ * @brief Upper bound on the length of a Newick string with parents and branch lengths
+ * @tparam T branch length type
+ * @param numLeaves number of leaves
+ * @param precision number of decimals of the branch lengths (or SHORTEST_PRECISION)
+ * @return size_t maximum number of chars (including the final ';')
+ */
+template <typename T = float>
+size_t getMaxNewickWithBranchesLength(size_t numLeaves, int precision = SHORTEST_PRECISION);
+
+/**
+ * @brief Build a Newick string with parents and branch lengths from an ancestry
+ * in linear time, into a single buffer
+ * @param ancestry vector of cherry triplets {child1, child2, parent}
+ * with parents in the range n..2n-2 (as output by getAncestry)
+ * @param branches branch lengths {branch1, branch2} of the children of each cherry
+ * (std::vector<std::array<T, 2>> or BranchColumns<T>)
+ * @param precision number of decimals of the branch lengths
+ * (default: shortest round-trip representation)
+ * @return std::string Newick string
+ */
+template <typename Branches>
+std::string buildNewickWithBranches(const Ancestry &ancestry, const Branches &branches,
+                                    int precision = SHORTEST_PRECISION);
+
+/**
+ * @brief buildNewickWithBranches into an existing string (overwritten)
+ */
+template <typename Branches>
+void buildNewickWithBranches(const Ancestry &ancestry, const Branches &branches,
+                             std::string &newick, int precision = SHORTEST_PRECISION);
 
-std::string toNewick(const PhyloMat &m);
+/**
+ * @brief Recover a rooted tree with branch lengths (in Newick format) from a Phylo2Mat m
+ * @param m Phylo2Mat matrix
+ * @param precision number of decimals of the branch lengths
+ * (default: shortest round-trip representation)
+ * @return std::string Newick string
+ * @throws std::invalid_argument if m does not have one row of branch lengths per cherry
+ */
+template <typename T, BranchLayout Layout>
+std::string toNewick(const BasicPhyloMat<T, Layout> &m, int precision = SHORTEST_PRECISION);
 
-#endif // MATRIX_TO_NEWICK_HPP
\ No newline at end of file
+#endif // MATRIX_TO_NEWICK_HPP
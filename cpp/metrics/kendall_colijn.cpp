@@ -0,0 +1,290 @@
+#include "kendall_colijn.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+#include "../utils/parallel.hpp"
+#include "leaf_pairs.hpp"
+
+// On x86-64 with GCC, also compile the distance kernel for AVX2 (wider vectors than the
+// baseline SSE2) and pick the version at load time
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define SIMD_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define SIMD_CLONES
+#endif
+
+// Memory budget of the vectors held at once by kendallColijnAllPairs
+static constexpr size_t KC_BLOCK_BYTES = size_t(256) << 20;
+
+// Number of rows/columns of a tile of pairs of trees, and number of entries of the vectors
+// compared at once within a tile
+static constexpr size_t KC_TILE_SIZE = 8;
+static constexpr size_t KC_SEGMENT_SIZE = 2048;
+
+size_t getKendallColijnSize(size_t numLeaves) {
+    return numLeaves * (numLeaves - 1) / 2 + numLeaves;
+}
+
+static void checkSameNumLeaves(size_t numLeaves1, size_t numLeaves2) {
+    if (numLeaves1 != numLeaves2) {
+        std::ostringstream oss;
+        oss << "Trees must have the same number of leaves (got " << numLeaves1 << " and "
+            << numLeaves2 << ")";
+        throw std::invalid_argument(oss.str());
+    }
+}
+
+static void checkLambda(double lambda) {
+    if (!(lambda >= 0 && lambda <= 1)) {
+        std::ostringstream oss;
+        oss << "lambda must be in [0, 1] (got " << lambda << ")";
+        throw std::invalid_argument(oss.str());
+    }
+}
+
+// Fill the vector of a tree whose edge to child j of cherry i has length branchLength(i, j).
+// Distances to the root are additive, so a single pass over the edges with the mixed lengths
+// (1 - lambda) + lambda * length gives the mixed vector.
+template <typename BranchLength>
+static void fillVector(const PhyloVec &v, BranchLength branchLength, float *out,
+                       unsigned int numThreads) {
+    const size_t numLeaves = v.size() + 1;
+
+    LeafPairTree tree = getLeafPairTree(v);
+    std::vector<double> heights = getHeights(tree, branchLength);
+
+    // Common ancestor depths, in condensed order
+    fillLeafPairs(tree, out, DistanceLayout::Condensed, 0, numLeaves, numThreads,
+                  [&](size_t, unsigned int p) {
+                      const float height = heights[p];
+                      return [height](unsigned int) { return height; };
+                  });
+
+    // Pendant edges
+    float *pendant = out + numLeaves * (numLeaves - 1) / 2;
+    for (size_t i = 0; i < tree.children.size(); ++i) {
+        for (unsigned int j = 0; j < 2; ++j) {
+            unsigned int child = tree.children[i][j];
+            if (child < numLeaves) {
+                pendant[child] = branchLength(i, j);
+            }
+        }
+    }
+}
+
+void kendallColijnVector(const PhyloVec &v, float *out, unsigned int numThreads) {
+    fillVector(v, [](size_t, unsigned int) { return 1.0; }, out, numThreads);
+}
+
+std::vector<float> kendallColijnVector(const PhyloVec &v, unsigned int numThreads) {
+    std::vector<float> out(getKendallColijnSize(v.size() + 1));
+    kendallColijnVector(v, out.data(), numThreads);
+    return out;
+}
+
+template <typename T, BranchLayout Layout>
+static void fillVector(const BasicPhyloMat<T, Layout> &m, double lambda, float *out,
+                       unsigned int numThreads) {
+    typedef ArithmeticType<T> P;
+    auto branchLength = [&](size_t i, unsigned int j) {
+        return (1 - lambda) + lambda * double(P(m.branches[i][j]));
+    };
+    fillVector(m.v, branchLength, out, numThreads);
+}
+
+template <typename T, BranchLayout Layout>
+void kendallColijnVector(const BasicPhyloMat<T, Layout> &m, double lambda, float *out,
+                         unsigned int numThreads) {
+    checkLambda(lambda);
+    checkBranches(m);
+    fillVector(m, lambda, out, numThreads);
+}
+
+template <typename T, BranchLayout Layout>
+std::vector<float> kendallColijnVector(const BasicPhyloMat<T, Layout> &m, double lambda,
+                                       unsigned int numThreads) {
+    std::vector<float> out(getKendallColijnSize(m.v.size() + 1));
+    kendallColijnVector(m, lambda, out.data(), numThreads);
+    return out;
+}
+
+// Squared Euclidean distance between two vectors, summed in double precision
+// over independent lanes so that the loop vectorizes without reassociating a single sum
+SIMD_CLONES
+static double getSquaredDistance(const float *x, const float *y, size_t size) {
+    constexpr size_t LANES = 8;
+
+    double sums[LANES] = {};
+    size_t k = 0;
+    for (; k + LANES <= size; k += LANES) {
+        for (size_t l = 0; l < LANES; ++l) {
+            double d = double(x[k + l]) - double(y[k + l]);
+            sums[l] += d * d;
+        }
+    }
+
+    double sum = 0;
+    for (; k < size; ++k) {
+        double d = double(x[k]) - double(y[k]);
+        sum += d * d;
+    }
+    for (size_t l = 0; l < LANES; ++l) {
+        sum += sums[l];
+    }
+    return sum;
+}
+
+double kendallColijn(const PhyloVec &v1, const PhyloVec &v2) {
+    checkSameNumLeaves(v1.size() + 1, v2.size() + 1);
+
+    std::vector<float> x = kendallColijnVector(v1);
+    std::vector<float> y = kendallColijnVector(v2);
+
+    return std::sqrt(getSquaredDistance(x.data(), y.data(), x.size()));
+}
+
+template <typename T, BranchLayout Layout>
+double kendallColijn(const BasicPhyloMat<T, Layout> &m1, const BasicPhyloMat<T, Layout> &m2,
+                     double lambda) {
+    checkSameNumLeaves(m1.v.size() + 1, m2.v.size() + 1);
+
+    std::vector<float> x = kendallColijnVector(m1, lambda);
+    std::vector<float> y = kendallColijnVector(m2, lambda);
+
+    return std::sqrt(getSquaredDistance(x.data(), y.data(), x.size()));
+}
+
+// Distances between all pairs of numTrees trees, where fill(t, out) fills the vector of tree t
+template <typename Fill>
+static std::vector<double> getAllPairs(size_t numTrees, size_t numLeaves, Fill fill,
+                                       unsigned int numThreads) {
+    const size_t size = getKendallColijnSize(numLeaves);
+
+    // Two blocks of vectors are held at once
+    const size_t blockSize =
+        std::clamp<size_t>(KC_BLOCK_BYTES / (2 * size * sizeof(float)), 1, numTrees);
+
+    std::vector<float> rowVectors(blockSize * size);
+    std::vector<float> columnVectors;
+
+    auto fillBlock = [&](std::vector<float> &vectors, size_t begin, size_t count) {
+        parallelFor(count, numThreads,
+                    [&](size_t t, unsigned int) { fill(begin + t, vectors.data() + t * size); });
+    };
+
+    std::vector<double> distances(numTrees * numTrees, 0);
+
+    for (size_t rowBegin = 0; rowBegin < numTrees; rowBegin += blockSize) {
+        const size_t numRows = std::min(blockSize, numTrees - rowBegin);
+        fillBlock(rowVectors, rowBegin, numRows);
+
+        for (size_t columnBegin = rowBegin; columnBegin < numTrees; columnBegin += blockSize) {
+            const size_t numColumns = std::min(blockSize, numTrees - columnBegin);
+
+            const float *columns = rowVectors.data();
+            if (columnBegin != rowBegin) {
+                columnVectors.resize(blockSize * size);
+                fillBlock(columnVectors, columnBegin, numColumns);
+                columns = columnVectors.data();
+            }
+
+            // Tiles of pairs are computed segment by segment,
+            // so that the segments of the vectors of a tile stay in cache
+            const size_t numRowTiles = (numRows + KC_TILE_SIZE - 1) / KC_TILE_SIZE;
+            const size_t numColumnTiles = (numColumns + KC_TILE_SIZE - 1) / KC_TILE_SIZE;
+
+            parallelFor(numRowTiles * numColumnTiles, numThreads, [&](size_t tile, unsigned int) {
+                const size_t iBegin = rowBegin + tile / numColumnTiles * KC_TILE_SIZE;
+                const size_t iEnd = std::min(iBegin + KC_TILE_SIZE, rowBegin + numRows);
+                const size_t jBegin = columnBegin + tile % numColumnTiles * KC_TILE_SIZE;
+                const size_t jEnd = std::min(jBegin + KC_TILE_SIZE, columnBegin + numColumns);
+                if (jEnd <= iBegin + 1) {
+                    // Lower triangle
+                    return;
+                }
+
+                double sums[KC_TILE_SIZE][KC_TILE_SIZE] = {};
+                for (size_t k = 0; k < size; k += KC_SEGMENT_SIZE) {
+                    const size_t count = std::min(KC_SEGMENT_SIZE, size - k);
+                    for (size_t i = iBegin; i < iEnd; ++i) {
+                        const float *x = rowVectors.data() + (i - rowBegin) * size + k;
+                        for (size_t j = std::max(jBegin, i + 1); j < jEnd; ++j) {
+                            const float *y = columns + (j - columnBegin) * size + k;
+                            sums[i - iBegin][j - jBegin] += getSquaredDistance(x, y, count);
+                        }
+                    }
+                }
+
+                // Each pair fills its entry of the upper triangle and mirrors it
+                for (size_t i = iBegin; i < iEnd; ++i) {
+                    for (size_t j = std::max(jBegin, i + 1); j < jEnd; ++j) {
+                        double distance = std::sqrt(sums[i - iBegin][j - jBegin]);
+                        distances[i * numTrees + j] = distance;
+                        distances[j * numTrees + i] = distance;
+                    }
+                }
+            });
+        }
+    }
+
+    return distances;
+}
+
+std::vector<double> kendallColijnAllPairs(const std::vector<PhyloVec> &vs,
+                                          unsigned int numThreads) {
+    if (vs.empty()) {
+        return {};
+    }
+
+    const size_t numLeaves = vs[0].size() + 1;
+    for (const auto &v : vs) {
+        checkSameNumLeaves(numLeaves, v.size() + 1);
+    }
+
+    return getAllPairs(
+        vs.size(), numLeaves,
+        [&](size_t t, float *out) {
+            fillVector(vs[t], [](size_t, unsigned int) { return 1.0; }, out, 1);
+        },
+        numThreads);
+}
+
+template <typename T, BranchLayout Layout>
+std::vector<double> kendallColijnAllPairs(const std::vector<BasicPhyloMat<T, Layout>> &ms,
+                                          double lambda, unsigned int numThreads) {
+    checkLambda(lambda);
+
+    if (ms.empty()) {
+        return {};
+    }
+
+    const size_t numLeaves = ms[0].v.size() + 1;
+    for (const auto &m : ms) {
+        checkSameNumLeaves(numLeaves, m.v.size() + 1);
+        checkBranches(m);
+    }
+
+    return getAllPairs(
+        ms.size(), numLeaves, [&](size_t t, float *out) { fillVector(ms[t], lambda, out, 1); },
+        numThreads);
+}
+
+#define INSTANTIATE_KENDALL_COLIJN(T, Layout)                                                     \
+    template void kendallColijnVector(const BasicPhyloMat<T, Layout> &, double, float *,          \
+                                      unsigned int);                                              \
+    template std::vector<float> kendallColijnVector(const BasicPhyloMat<T, Layout> &, double,     \
+                                                    unsigned int);                                \
+    template double kendallColijn(const BasicPhyloMat<T, Layout> &,                               \
+                                  const BasicPhyloMat<T, Layout> &, double);                      \
+    template std::vector<double> kendallColijnAllPairs(                                           \
+        const std::vector<BasicPhyloMat<T, Layout>> &, double, unsigned int);
+
+INSTANTIATE_KENDALL_COLIJN(float, BranchLayout::AoS)
+INSTANTIATE_KENDALL_COLIJN(float, BranchLayout::SoA)
+INSTANTIATE_KENDALL_COLIJN(double, BranchLayout::AoS)
+INSTANTIATE_KENDALL_COLIJN(double, BranchLayout::SoA)
+INSTANTIATE_KENDALL_COLIJN(Half, BranchLayout::AoS)
+INSTANTIATE_KENDALL_COLIJN(Half, BranchLayout::SoA)
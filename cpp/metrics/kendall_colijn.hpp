@@ -0,0 +1,127 @@
+#ifndef KENDALL_COLIJN_HPP
+#define KENDALL_COLIJN_HPP
+
+/**
+ * @file kendall_colijn.hpp
+ * @brief Kendall-Colijn vectors and distances between rooted trees with the same leaves
+ *
+ * The vector of a tree with n leaves has n * (n - 1) / 2 + n entries:
+ * for each pair of leaves i < j (in the order of a condensed distance matrix),
+ * the distance from the root to their common ancestor,
+ * then, for each leaf, the length of its pendant edge.
+ * Topological vectors count edges (every edge has length 1).
+ * With branch lengths, a parameter lambda in [0, 1] mixes both:
+ * (1 - lambda) * topological vector + lambda * vector with branch lengths.
+ * The distance between two trees is the Euclidean distance between their vectors.
+ */
+
+#include <vector>
+
+#include "../base/core.hpp"
+#include "../matrix/core.hpp"
+
+/**
+ * @brief Number of entries of the Kendall-Colijn vector of a tree
+ * @param numLeaves number of leaves
+ * @return size_t n * (n - 1) / 2 + n
+ */
+size_t getKendallColijnSize(size_t numLeaves);
+
+/**
+ * @brief Topological Kendall-Colijn vector of a tree, into a buffer
+ * All entries are filled in one pass over the pairs of leaves (see copheneticDistances).
+ * @param v Phylo2Vec vector
+ * @param out output buffer of getKendallColijnSize(v.size() + 1) entries
+ * @param numThreads number of threads (0 = all hardware threads)
+ */
+void kendallColijnVector(const PhyloVec &v, float *out, unsigned int numThreads = 0);
+
+/**
+ * @brief Topological Kendall-Colijn vector of a tree
+ * @param v Phylo2Vec vector
+ * @param numThreads number of threads (0 = all hardware threads)
+ * @return std::vector<float> vector of getKendallColijnSize(v.size() + 1) entries
+ */
+std::vector<float> kendallColijnVector(const PhyloVec &v, unsigned int numThreads = 0);
+
+/**
+ * @brief Kendall-Colijn vector of a tree with branch lengths, into a buffer
+ * @tparam T branch length type (float, double or Half)
+ * @tparam Layout memory layout of the branch lengths
+ * @param m Phylo2Mat matrix
+ * @param lambda weight of the branch lengths, in [0, 1] (0 = topological vector)
+ * @param out output buffer of getKendallColijnSize(m.v.size() + 1) entries
+ * @param numThreads number of threads (0 = all hardware threads)
+ * @throws std::invalid_argument if lambda is not in [0, 1]
+ * or if m does not have one row of branch lengths per cherry
+ */
+template <typename T, BranchLayout Layout>
+void kendallColijnVector(const BasicPhyloMat<T, Layout> &m, double lambda, float *out,
+                         unsigned int numThreads = 0);
+
+/**
+ * @brief Kendall-Colijn vector of a tree with branch lengths
+ * @param m Phylo2Mat matrix
+ * @param lambda weight of the branch lengths, in [0, 1]
+ * @param numThreads number of threads (0 = all hardware threads)
+ * @return std::vector<float> vector of getKendallColijnSize(m.v.size() + 1) entries
+ * @throws std::invalid_argument if lambda is not in [0, 1]
+ * or if m does not have one row of branch lengths per cherry
+ */
+template <typename T, BranchLayout Layout>
+std::vector<float> kendallColijnVector(const BasicPhyloMat<T, Layout> &m, double lambda,
+                                       unsigned int numThreads = 0);
+
+/**
+ * @brief Topological Kendall-Colijn distance between two trees
+ * @param v1 first Phylo2Vec vector
+ * @param v2 second Phylo2Vec vector
+ * @return double distance
+ * @throws std::invalid_argument if the trees have different numbers of leaves
+ */
+double kendallColijn(const PhyloVec &v1, const PhyloVec &v2);
+
+/**
+ * @brief Kendall-Colijn distance between two trees with branch lengths
+ * @param m1 first Phylo2Mat matrix
+ * @param m2 second Phylo2Mat matrix
+ * @param lambda weight of the branch lengths, in [0, 1]
+ * @return double distance
+ * @throws std::invalid_argument if the trees have different numbers of leaves,
+ * if lambda is not in [0, 1] or if a matrix does not have one row of branch lengths per cherry
+ */
+template <typename T, BranchLayout Layout>
+double kendallColijn(const BasicPhyloMat<T, Layout> &m1, const BasicPhyloMat<T, Layout> &m2,
+                     double lambda);
+
+/**
+ * @brief Topological Kendall-Colijn distances between all pairs of K trees
+ * Trees are processed in blocks whose vectors fit in a fixed memory budget:
+ * the vectors of two blocks are computed once (in parallel over trees),
+ * then the distances between their trees are computed in parallel over tiles of pairs,
+ * segment by segment so that the vectors of a tile are read from cache,
+ * with a sum of squares reduced over independent lanes (vectorized by the compiler).
+ * If all vectors fit in the budget, each vector is computed exactly once.
+ * @param vs Phylo2Vec vectors, all with the same number of leaves
+ * @param numThreads number of threads (0 = all hardware threads)
+ * @return std::vector<double> row-major K x K distance matrix
+ * @throws std::invalid_argument if the trees have different numbers of leaves
+ */
+std::vector<double> kendallColijnAllPairs(const std::vector<PhyloVec> &vs,
+                                          unsigned int numThreads = 0);
+
+/**
+ * @brief Kendall-Colijn distances between all pairs of K trees with branch lengths
+ * (as the topological version)
+ * @param ms Phylo2Mat matrices, all with the same number of leaves
+ * @param lambda weight of the branch lengths, in [0, 1]
+ * @param numThreads number of threads (0 = all hardware threads)
+ * @return std::vector<double> row-major K x K distance matrix
+ * @throws std::invalid_argument if the trees have different numbers of leaves,
+ * if lambda is not in [0, 1] or if a matrix does not have one row of branch lengths per cherry
+ */
+template <typename T, BranchLayout Layout>
+std::vector<double> kendallColijnAllPairs(const std::vector<BasicPhyloMat<T, Layout>> &ms,
+                                          double lambda, unsigned int numThreads = 0);
+
+#endif  // KENDALL_COLIJN_HPP
@@ -0,0 +1,48 @@
+#include "leaf_pairs.hpp"
+
+#include <utility>
+
+#include "../base/to_newick.hpp"
+
+LeafPairTree getLeafPairTree(const PhyloVec &v) {
+    const unsigned int numLeaves = v.size() + 1;
+    const unsigned int numNodes = 2 * numLeaves - 1;
+
+    LeafPairTree tree;
+
+    // Children of internal nodes (as in buildNewick)
+    tree.root = getChildren(getPairs(v), numLeaves, tree.children);
+
+    tree.parent.assign(numNodes, tree.root);
+    tree.start.resize(numNodes);
+    tree.end.resize(numNodes);
+    tree.leafOrder.reserve(numLeaves);
+
+    // Iterative DFS (internal nodes are popped twice: on entry and on exit)
+    std::vector<std::pair<unsigned int, bool>> stack = {{tree.root, false}};
+    while (!stack.empty()) {
+        auto [node, exiting] = stack.back();
+        stack.pop_back();
+
+        if (exiting) {
+            tree.end[node] = tree.leafOrder.size();
+            continue;
+        }
+
+        tree.start[node] = tree.leafOrder.size();
+
+        if (node < numLeaves) {
+            tree.leafOrder.push_back(node);
+            tree.end[node] = tree.leafOrder.size();
+            continue;
+        }
+
+        stack.push_back({node, true});
+        for (unsigned int child : tree.children[node - numLeaves]) {
+            tree.parent[child] = node;
+            stack.push_back({child, false});
+        }
+    }
+
+    return tree;
+}
@@ -0,0 +1,115 @@
+#ifndef LEAF_PAIRS_HPP
+#define LEAF_PAIRS_HPP
+
+/**
+ * @file leaf_pairs.hpp
+ * @brief Kernel over all pairs of leaves of a tree, shared by the pairwise metrics
+ */
+
+#include <vector>
+
+#include "../base/core.hpp"
+#include "../utils/parallel.hpp"
+#include "pairwise.hpp"
+
+/**
+ * @brief Structure of a tree needed to enumerate pairs of leaves with their common ancestor
+ * Internal node numLeaves + i is the parent of row i of the ancestry (see getAncestry).
+ */
+struct LeafPairTree {
+    unsigned int root;
+    // Parent of each node
+    std::vector<unsigned int> parent;
+    // Children of internal node numLeaves + i
+    std::vector<Pair> children;
+    // Leaves in DFS order: the leaves of the subtree of a node
+    // are leafOrder[start[node]:end[node]]
+    std::vector<unsigned int> leafOrder;
+    std::vector<unsigned int> start;
+    std::vector<unsigned int> end;
+
+    size_t getNumLeaves() const { return leafOrder.size(); }
+};
+
+/**
+ * @brief Build the structure of the tree of a Phylo2Vec vector in O(n)
+ */
+LeafPairTree getLeafPairTree(const PhyloVec &v);
+
+/**
+ * @brief Distance of each node to the root
+ * Parents have higher labels than their children, so nodes are visited from the root down.
+ * @param tree tree structure
+ * @param branchLength callable returning the length of the edge to child j of cherry i
+ * @return std::vector<double> height of each node
+ */
+template <typename BranchLength>
+std::vector<double> getHeights(const LeafPairTree &tree, BranchLength branchLength) {
+    const size_t numCherries = tree.children.size();
+
+    std::vector<double> heights(2 * numCherries + 1, 0);
+    for (size_t i = numCherries; i-- > 0;) {
+        double parentHeight = heights[numCherries + 1 + i];
+        for (unsigned int j = 0; j < 2; ++j) {
+            heights[tree.children[i][j]] = parentHeight + branchLength(i, j);
+        }
+    }
+
+    return heights;
+}
+
+/**
+ * @brief Fill a value for each pair of leaves (a, b) of the rows [rowBegin, rowEnd)
+ * of a flat matrix, in parallel over blocks of rows, in O(n) per row:
+ * each row walks from leaf a to the root, and the leaves b of the sibling subtree
+ * of each node on the way (contiguous in DFS order) have its parent p as common ancestor.
+ * @param tree tree structure
+ * @param out flat matrix (see DistanceLayout; the diagonal of a square matrix is set to 0)
+ * @param layout layout of the matrix
+ * @param rowBegin first row
+ * @param rowEnd end of the rows
+ * @param numThreads number of threads (0 = all hardware threads)
+ * @param getRowValue callable (a, p) returning a callable b -> value of (a, b)
+ * for the leaves b whose common ancestor with a is p
+ */
+template <typename D, typename GetRowValue>
+void fillLeafPairs(const LeafPairTree &tree, D *out, DistanceLayout layout, size_t rowBegin,
+                   size_t rowEnd, unsigned int numThreads, GetRowValue getRowValue) {
+    // Number of consecutive rows filled by a thread at once
+    constexpr size_t ROW_BLOCK_SIZE = 16;
+
+    const unsigned int numLeaves = tree.getNumLeaves();
+
+    auto fillRow = [&](size_t i, unsigned int) {
+        const size_t a = rowBegin + i;
+
+        // Output row of leaf a, indexed by leaf b
+        // (in the condensed layout, only b > a is stored)
+        D *row;
+        if (layout == DistanceLayout::Square) {
+            row = out + a * numLeaves;
+            row[a] = 0;
+        } else {
+            row = out + getCondensedIndex(numLeaves, a, a + 1) - (a + 1);
+        }
+
+        for (unsigned int u = a; u != tree.root; u = tree.parent[u]) {
+            unsigned int p = tree.parent[u];
+            const Pair &children = tree.children[p - numLeaves];
+            unsigned int sibling = children[0] == u ? children[1] : children[0];
+
+            auto value = getRowValue(a, p);
+
+            for (unsigned int k = tree.start[sibling]; k < tree.end[sibling]; ++k) {
+                unsigned int b = tree.leafOrder[k];
+                if (layout == DistanceLayout::Square || b > a) {
+                    row[b] = value(b);
+                }
+            }
+        }
+    };
+
+    parallelFor(rowEnd - rowBegin, numThreads, fillRow, ROW_BLOCK_SIZE);
+}
+
+#endif  // LEAF_PAIRS_HPP
@@ -1,74 +1,196 @@
 #include "pairwise.hpp"
 
+#include <chrono>
+#include <cstring>
 #include <sstream>
 #include <stdexcept>
 
 #include "../base/to_newick.hpp"
 #include "../ops/vector.hpp"
+#include "../utils/mapped_file.hpp"
+#include "../utils/parallel.hpp"
+#include "kendall_colijn.hpp"
+#include "leaf_pairs.hpp"
+#include "robinson_foulds.hpp"
 
-Matrix copheneticDistances(const PhyloVec &v, bool unrooted) {
-    const size_t numLeaves = v.size() + 1;
+const char DISTANCE_MAGIC[8] = {'P', '2', 'V', 'D', 'I', 'S', 'T', '\0'};
 
-    Ancestry anc = getAncestry(v);
+size_t getDistanceMatrixSize(size_t numLeaves, DistanceLayout layout) {
+    return layout == DistanceLayout::Square ? numLeaves * numLeaves
+                                            : numLeaves * (numLeaves - 1) / 2;
+}
 
-    if (unrooted) {
-        anc[anc.size() - 1][anc.size() - 1] -= 1;
-    }
+// Fill the distances d(a, b) = heights[a] + heights[b] - 2 * heights[lca(a, b)]
+// (+ rootOffset if the path goes through the root) of the rows [rowBegin, rowEnd)
+template <typename D>
+static void fillDistances(const LeafPairTree &tree, const std::vector<double> &heights,
+                          double rootOffset, D *out, DistanceLayout layout,
+                          unsigned int numThreads, size_t rowBegin, size_t rowEnd) {
+    fillLeafPairs(tree, out, layout, rowBegin, rowEnd, numThreads, [&](size_t a, unsigned int p) {
+        const double aHeight = heights[a];
+        double ancestorHeights = 2 * heights[p];
+        if (p == tree.root) {
+            ancestorHeights -= rootOffset;
+        }
+        // heights[a] + heights[b] is computed first so that d(a, b) == d(b, a) exactly
+        return [&heights, aHeight, ancestorHeights](unsigned int b) {
+            return D((aHeight + heights[b]) - ancestorHeights);
+        };
+    });
+}
+
+// Fill all rows
+template <typename D>
+static void fillDistances(const LeafPairTree &tree, const std::vector<double> &heights,
+                          double rootOffset, D *out, DistanceLayout layout,
+                          unsigned int numThreads) {
+    fillDistances(tree, heights, rootOffset, out, layout, numThreads, 0, tree.getNumLeaves());
+}
 
-    const size_t numNodes = 2 * numLeaves - 1;
+// Write the distances to a mapped file, chunk by chunk
+template <typename D>
+static void writeDistances(const std::string &path, const LeafPairTree &tree,
+                           const std::vector<double> &heights, double rootOffset,
+                           DistanceLayout layout, unsigned int numThreads,
+                           const DistanceProgressCallback &progress, size_t chunkBytes) {
+    const size_t numLeaves = tree.getNumLeaves();
 
-    // Initialize with zeros
-    // std::vector<int> fullZeros(numNodes, 0);
-    Matrix fullD(numNodes, std::vector<float>(numNodes, 0));
-    // for (size_t i = 0; i < numNodes; ++i) {
-    //     std::vector<int> row(numNodes, 0);
-    //     D.push_back(row);
-    // }
+    DistanceHeader header;
+    std::memcpy(header.magic, DISTANCE_MAGIC, sizeof(DISTANCE_MAGIC));
+    header.version = DISTANCE_FORMAT_VERSION;
+    header.numLeaves = numLeaves;
+    header.layout = layout == DistanceLayout::Square ? 0 : 1;
+    header.valueSize = sizeof(D);
+    header.count = getDistanceMatrixSize(numLeaves, layout);
 
-    std::vector<int> allVisited;
+    MappedOutputFile file(path, sizeof(header) + header.count * sizeof(D));
+    std::memcpy(file.data(), &header, sizeof(header));
+    D *out = reinterpret_cast<D *>(file.data() + sizeof(header));
 
-    for (size_t i = 0; i < numLeaves - 1; ++i) {
-        auto &[c1, c2, p] = anc[numLeaves - i - 2];
+    // Position of the first value of row a (or of the end of the matrix for a = numLeaves)
+    auto getRowStart = [&](size_t a) {
+        return layout == DistanceLayout::Square ? a * numLeaves
+                                                : a * numLeaves - a * (a + 1) / 2;
+    };
 
-        for (int j = 0; j < allVisited.size() - 1; ++j) {
-            size_t visited = allVisited[j];
-            // new distance from c1/c2 to visited is
-            // 1 + the distance from p to visited
-            float distFromVisited = fullD[p][visited] + 1.0;
+    const auto startTime = std::chrono::steady_clock::now();
 
-            // c1 to visited
-            fullD[c1][visited] = distFromVisited;
-            fullD[visited][c1] = distFromVisited;
+    // Byte range of the previous chunk, being written back while the current one is filled
+    size_t pendingOffset = 0, pendingCount = 0;
 
-            // c2 to visited
-            fullD[c2][visited] = distFromVisited;
-            fullD[visited][c2] = distFromVisited;
+    for (size_t rowBegin = 0; rowBegin < numLeaves;) {
+        // As many rows as fit in a chunk (at least one)
+        size_t rowEnd = rowBegin + 1;
+        while (rowEnd < numLeaves &&
+               (getRowStart(rowEnd + 1) - getRowStart(rowBegin)) * sizeof(D) <= chunkBytes) {
+            ++rowEnd;
         }
 
-        // c1 to c2: path length = 2 --> c1 -- p --c2
-        fullD[c1][c2] = 2.0;
-        fullD[c2][c1] = 2.0;
-        // c1 to parent: path length = 1 --> c1 -- p
-        fullD[c1][p] = 1.0;
-        fullD[p][c1] = 1.0;
-        // c2 to parent: path length = 1 --> c2 -- p
-        fullD[c2][p] = 1.0;
-        fullD[p][c2] = 1.0;
-
-        // all_visited.extend([c1, c2, p])
-        allVisited.push_back(c1);
-        allVisited.push_back(c2);
-        allVisited.push_back(p);
+        fillDistances(tree, heights, rootOffset, out, layout, numThreads, rowBegin, rowEnd);
+
+        const size_t offset = sizeof(header) + getRowStart(rowBegin) * sizeof(D);
+        const size_t count = (getRowStart(rowEnd) - getRowStart(rowBegin)) * sizeof(D);
+        file.startWriteBack(offset, count);
+
+        // Wait for the previous chunk (written while this one was filled) and release its pages
+        file.flush(pendingOffset, pendingCount);
+        pendingOffset = offset;
+        pendingCount = count;
+
+        rowBegin = rowEnd;
+
+        if (progress) {
+            const size_t bytesWritten = getRowStart(rowEnd) * sizeof(D);
+            const double seconds =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime)
+                    .count();
+            progress({rowEnd, numLeaves, bytesWritten, seconds,
+                      seconds > 0 ? bytesWritten / seconds : 0.0});
+        }
     }
 
-    // leafD = fullD[:numLeaves, :numLeaves]
-    Matrix leafD(numLeaves, std::vector<float>(numLeaves, 0));
+    file.flush(pendingOffset, pendingCount);
+    file.flush(0, sizeof(header));
+}
+
+void copheneticDistances(const PhyloVec &v, float *out, DistanceLayout layout, bool unrooted,
+                         unsigned int numThreads) {
+    LeafPairTree tree = getLeafPairTree(v);
+
+    // Every edge has length 1
+    std::vector<double> depths = getHeights(tree, [](size_t, unsigned int) { return 1.0; });
+
+    fillDistances(tree, depths, unrooted ? -1.0 : 0.0, out, layout, numThreads);
+}
 
-    for (size_t i = 0; i < numLeaves; ++i) {
-        leafD[i] = std::vector<float>(fullD[i].begin(), fullD[i].begin() + numLeaves);
+std::vector<float> copheneticDistancesFlat(const PhyloVec &v, DistanceLayout layout,
+                                           bool unrooted, unsigned int numThreads) {
+    std::vector<float> distances(getDistanceMatrixSize(v.size() + 1, layout));
+    copheneticDistances(v, distances.data(), layout, unrooted, numThreads);
+    return distances;
+}
+
+// Copy a flat square matrix of numRows x numRows entries to a Matrix
+template <typename D>
+static Matrix unflatten(const std::vector<D> &flat, size_t numRows) {
+    Matrix matrix(numRows);
+    for (size_t i = 0; i < numRows; ++i) {
+        matrix[i].assign(flat.begin() + i * numRows, flat.begin() + (i + 1) * numRows);
     }
+    return matrix;
+}
+
+Matrix copheneticDistances(const PhyloVec &v, bool unrooted) {
+    return unflatten(copheneticDistancesFlat(v, DistanceLayout::Square, unrooted), v.size() + 1);
+}
+
+template <typename T, BranchLayout Layout>
+void patristicDistances(const BasicPhyloMat<T, Layout> &m, ArithmeticType<T> *out,
+                        DistanceLayout layout, unsigned int numThreads) {
+    typedef ArithmeticType<T> P;
+
+    checkBranches(m);
+    LeafPairTree tree = getLeafPairTree(m.v);
+
+    std::vector<double> heights = getHeights(
+        tree, [&](size_t i, unsigned int j) { return double(P(m.branches[i][j])); });
+
+    fillDistances(tree, heights, 0.0, out, layout, numThreads);
+}
+
+template <typename T, BranchLayout Layout>
+std::vector<ArithmeticType<T>> patristicDistancesFlat(const BasicPhyloMat<T, Layout> &m,
+                                                      DistanceLayout layout,
+                                                      unsigned int numThreads) {
+    std::vector<ArithmeticType<T>> distances(getDistanceMatrixSize(m.v.size() + 1, layout));
+    patristicDistances(m, distances.data(), layout, numThreads);
+    return distances;
+}
+
+void writeCopheneticDistances(const std::string &path, const PhyloVec &v,
+                              DistanceLayout layout, bool unrooted, unsigned int numThreads,
+                              const DistanceProgressCallback &progress, size_t chunkBytes) {
+    LeafPairTree tree = getLeafPairTree(v);
+
+    std::vector<double> depths = getHeights(tree, [](size_t, unsigned int) { return 1.0; });
+
+    writeDistances<float>(path, tree, depths, unrooted ? -1.0 : 0.0, layout, numThreads,
+                          progress, chunkBytes);
+}
 
-    return leafD;
+template <typename T, BranchLayout Layout>
+void writePatristicDistances(const std::string &path, const BasicPhyloMat<T, Layout> &m,
+                             DistanceLayout layout, unsigned int numThreads,
+                             const DistanceProgressCallback &progress, size_t chunkBytes) {
+    typedef ArithmeticType<T> P;
+
+    checkBranches(m);
+    LeafPairTree tree = getLeafPairTree(m.v);
+
+    std::vector<double> heights = getHeights(
+        tree, [&](size_t i, unsigned int j) { return double(P(m.branches[i][j])); });
+
+    writeDistances<P>(path, tree, heights, 0.0, layout, numThreads, progress, chunkBytes);
 }
 
 Matrix pairwiseDistances(const PhyloVec &v, std::string_view metric, bool unrooted) {
@@ -79,4 +201,73 @@ Matrix pairwiseDistances(const PhyloVec &v, std::string_view metric, bool unroot
         oss << "Invalid metric name: " << metric;
         throw std::invalid_argument(oss.str());
     }
-}
\ No newline at end of file
+}
+
+Matrix pairwiseDistances(const PhyloMat &m, std::string_view metric, bool unrooted) {
+    if (metric == "cophenetic") {
+        return copheneticDistances(m.v, unrooted);
+    } else if (metric == "patristic") {
+        return unflatten(patristicDistancesFlat(m), m.v.size() + 1);
+    } else {
+        std::ostringstream oss;
+        oss << "Invalid metric name: " << metric;
+        throw std::invalid_argument(oss.str());
+    }
+}
+
+static void checkRootedMetric(std::string_view metric, bool unrooted) {
+    if (unrooted) {
+        std::ostringstream oss;
+        oss << "Metric " << metric << " is only defined for rooted trees";
+        throw std::invalid_argument(oss.str());
+    }
+}
+
+Matrix pairwiseTreeDistances(const std::vector<PhyloVec> &vs, std::string_view metric,
+                             bool unrooted, unsigned int numThreads) {
+    if (metric == "robinson_foulds") {
+        return unflatten(robinsonFouldsAllPairs(vs, unrooted, numThreads), vs.size());
+    } else if (metric == "kendall_colijn") {
+        checkRootedMetric(metric, unrooted);
+        return unflatten(kendallColijnAllPairs(vs, numThreads), vs.size());
+    } else {
+        std::ostringstream oss;
+        oss << "Invalid metric name: " << metric;
+        throw std::invalid_argument(oss.str());
+    }
+}
+
+Matrix pairwiseTreeDistances(const std::vector<PhyloMat> &ms, std::string_view metric,
+                             double lambda, bool unrooted, unsigned int numThreads) {
+    if (metric == "robinson_foulds") {
+        std::vector<PhyloVec> vs;
+        vs.reserve(ms.size());
+        for (const auto &m : ms) {
+            vs.push_back(m.v);
+        }
+        return pairwiseTreeDistances(vs, metric, unrooted, numThreads);
+    } else if (metric == "kendall_colijn") {
+        checkRootedMetric(metric, unrooted);
+        return unflatten(kendallColijnAllPairs(ms, lambda, numThreads), ms.size());
+    } else {
+        std::ostringstream oss;
+        oss << "Invalid metric name: " << metric;
+        throw std::invalid_argument(oss.str());
+    }
+}
+
+#define INSTANTIATE_PATRISTIC(T, Layout)                                                          \
+    template void patristicDistances(const BasicPhyloMat<T, Layout> &, ArithmeticType<T> *,       \
+                                     DistanceLayout, unsigned int);                               \
+    template std::vector<ArithmeticType<T>> patristicDistancesFlat(                               \
+        const BasicPhyloMat<T, Layout> &, DistanceLayout, unsigned int);                          \
+    template void writePatristicDistances(const std::string &, const BasicPhyloMat<T, Layout> &,  \
+                                          DistanceLayout, unsigned int,                           \
+                                          const DistanceProgressCallback &, size_t);
+
+INSTANTIATE_PATRISTIC(float, BranchLayout::AoS)
+INSTANTIATE_PATRISTIC(float, BranchLayout::SoA)
+INSTANTIATE_PATRISTIC(double, BranchLayout::AoS)
+INSTANTIATE_PATRISTIC(double, BranchLayout::SoA)
+INSTANTIATE_PATRISTIC(Half, BranchLayout::AoS)
+INSTANTIATE_PATRISTIC(Half, BranchLayout::SoA)
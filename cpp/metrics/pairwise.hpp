@@ -1,9 +1,231 @@
+#ifndef PAIRWISE_HPP
+#define PAIRWISE_HPP
+
+/**
+ * @file pairwise.hpp
+ * @brief Pairwise distances between the leaves of a tree, and between trees
+ */
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
 #include "../base/core.hpp"
+#include "../matrix/core.hpp"
 
 // TODO: this should also cover double-valued matrices
 typedef std::vector<std::vector<float>> Matrix;
 
+/**
+ * @brief Layout of a flat (contiguous) distance matrix between n leaves
+ * Square: row-major n x n matrix
+ * Condensed: upper triangle without the diagonal, row by row
+ * (n * (n - 1) / 2 entries, as scipy.spatial.distance.pdist)
+ */
+enum class DistanceLayout { Square, Condensed };
+
+/**
+ * @brief Number of entries of a flat distance matrix
+ * @param numLeaves number of leaves
+ * @param layout layout of the matrix
+ * @return size_t number of entries
+ */
+size_t getDistanceMatrixSize(size_t numLeaves, DistanceLayout layout);
+
+/**
+ * @brief Position of the distance between leaves i < j in a condensed matrix
+ * @param numLeaves number of leaves
+ * @param i first leaf
+ * @param j second leaf (i < j)
+ * @return size_t index in the condensed matrix
+ */
+inline size_t getCondensedIndex(size_t numLeaves, size_t i, size_t j) {
+    return numLeaves * i - i * (i + 1) / 2 + (j - i - 1);
+}
+
+/**
+ * @brief Topological (cophenetic) distances between all leaves, into a flat buffer
+ * Runs in O(n^2) time without any internal-node matrix:
+ * each row is filled by walking from the leaf to the root,
+ * writing the leaves of each sibling subtree (contiguous in DFS order).
+ * Blocks of rows are filled in parallel.
+ * @param v Phylo2Vec vector
+ * @param out output buffer of getDistanceMatrixSize(v.size() + 1, layout) entries
+ * @param layout layout of the output
+ * @param unrooted if true, the two root edges are merged into one
+ * (distances between leaves on both sides of the root decrease by 1)
+ * @param numThreads number of threads (0 = all hardware threads)
+ */
+void copheneticDistances(const PhyloVec &v, float *out, DistanceLayout layout,
+                         bool unrooted = false, unsigned int numThreads = 0);
+
+/**
+ * @brief Topological (cophenetic) distances between all leaves, as a flat matrix
+ * @param v Phylo2Vec vector
+ * @param layout layout of the output
+ * @param unrooted if true, the two root edges are merged into one
+ * @param numThreads number of threads (0 = all hardware threads)
+ * @return std::vector<float> flat distance matrix
+ */
+std::vector<float> copheneticDistancesFlat(const PhyloVec &v,
+                                           DistanceLayout layout = DistanceLayout::Square,
+                                           bool unrooted = false, unsigned int numThreads = 0);
+
+/**
+ * @brief Topological (cophenetic) distances between all leaves
+ * @param v Phylo2Vec vector
+ * @param unrooted if true, the two root edges are merged into one
+ * @return Matrix n x n distance matrix
+ */
 Matrix copheneticDistances(const PhyloVec &v, bool unrooted = false);
 
+/**
+ * @brief Patristic distances (sums of branch lengths) between all leaves, into a flat buffer
+ * Same kernel as copheneticDistances, with the distance of each node to the root
+ * accumulated in double precision.
+ * Merging the two root edges of an unrooted tree does not change these distances.
+ * @tparam T branch length type (float, double or Half)
+ * @tparam Layout memory layout of the branch lengths
+ * @param m Phylo2Mat matrix
+ * @param out output buffer of getDistanceMatrixSize(m.v.size() + 1, layout) entries
+ * @param layout layout of the output
+ * @param numThreads number of threads (0 = all hardware threads)
+ * @throws std::invalid_argument if m does not have one row of branch lengths per cherry
+ */
+template <typename T, BranchLayout Layout>
+void patristicDistances(const BasicPhyloMat<T, Layout> &m, ArithmeticType<T> *out,
+                        DistanceLayout layout, unsigned int numThreads = 0);
+
+/**
+ * @brief Patristic distances between all leaves, as a flat matrix
+ * @param m Phylo2Mat matrix
+ * @param layout layout of the output
+ * @param numThreads number of threads (0 = all hardware threads)
+ * @return std::vector<ArithmeticType<T>> flat distance matrix
+ */
+template <typename T, BranchLayout Layout>
+std::vector<ArithmeticType<T>> patristicDistancesFlat(
+    const BasicPhyloMat<T, Layout> &m, DistanceLayout layout = DistanceLayout::Square,
+    unsigned int numThreads = 0);
+
+/**
+ * @brief Header of a distance matrix file
+ *
+ * File layout (in the byte order of the host that wrote it,
+ * i.e. little-endian on x86-64 and ARM64; files are not portable to big-endian hosts):
+ * - header (32 bytes): magic "P2VDIST", format version, number of leaves,
+ *   layout (0 = square, 1 = condensed), size of a value in bytes (4 or 8), number of values
+ * - the flat distance matrix, in the given layout
+ * (e.g., numpy.memmap(path, dtype=np.float32, offset=32))
+ */
+struct DistanceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t numLeaves;
+    uint32_t layout;
+    uint32_t valueSize;
+    uint64_t count;
+};
+
+static_assert(sizeof(DistanceHeader) == 32, "DistanceHeader must be 32 bytes");
+
+inline constexpr uint32_t DISTANCE_FORMAT_VERSION = 1;
+
+/**
+ * @brief Default number of output bytes computed between two write-backs to a distance file
+ */
+inline constexpr size_t DEFAULT_DISTANCE_CHUNK_BYTES = size_t(64) << 20;
+
+/**
+ * @brief Progress of the writing of a distance file, reported after each chunk of rows
+ */
+struct DistanceProgress {
+    size_t rowsDone;
+    size_t numRows;
+    size_t bytesWritten;
+    double seconds;
+    double bytesPerSecond;
+};
+
+typedef std::function<void(const DistanceProgress &)> DistanceProgressCallback;
+
+/**
+ * @brief Write the topological (cophenetic) distances between all leaves to a file
+ * The file is memory-mapped and filled in chunks of rows (in parallel within a chunk),
+ * each chunk being written back while the next one is computed, then released,
+ * so the memory used does not grow with the size of the matrix
+ * and the throughput is bounded by the slower of computation and disk.
+ * @param path output path (see DistanceHeader for the format, values are float)
+ * @param v Phylo2Vec vector
+ * @param layout layout of the matrix in the file
+ * @param unrooted if true, the two root edges are merged into one
+ * @param numThreads number of threads (0 = all hardware threads)
+ * @param progress called from the calling thread after each chunk (may be empty)
+ * @param chunkBytes approximate number of output bytes per chunk
+ * @throws std::system_error if the file cannot be created or written
+ */
+void writeCopheneticDistances(const std::string &path, const PhyloVec &v,
+                              DistanceLayout layout = DistanceLayout::Condensed,
+                              bool unrooted = false, unsigned int numThreads = 0,
+                              const DistanceProgressCallback &progress = nullptr,
+                              size_t chunkBytes = DEFAULT_DISTANCE_CHUNK_BYTES);
+
+/**
+ * @brief Write the patristic distances between all leaves to a file
+ * (as writeCopheneticDistances, with values of type ArithmeticType<T>)
+ * @throws std::invalid_argument if m does not have one row of branch lengths per cherry
+ */
+template <typename T, BranchLayout Layout>
+void writePatristicDistances(const std::string &path, const BasicPhyloMat<T, Layout> &m,
+                             DistanceLayout layout = DistanceLayout::Condensed,
+                             unsigned int numThreads = 0,
+                             const DistanceProgressCallback &progress = nullptr,
+                             size_t chunkBytes = DEFAULT_DISTANCE_CHUNK_BYTES);
+
+/**
+ * @brief Distances between all leaves of a tree
+ * @param v Phylo2Vec vector
+ * @param metric "cophenetic"
+ * @param unrooted if true, the two root edges are merged into one
+ * @return Matrix n x n distance matrix
+ */
 Matrix pairwiseDistances(const PhyloVec &v, std::string_view metric,
-                         bool unrooted = false);
\ No newline at end of file
+                         bool unrooted = false);
+
+/**
+ * @brief Distances between all leaves of a tree with branch lengths
+ * @param m Phylo2Mat matrix
+ * @param metric "cophenetic" (ignores branch lengths) or "patristic"
+ * @param unrooted if true, the two root edges are merged into one
+ * @return Matrix n x n distance matrix
+ */
+Matrix pairwiseDistances(const PhyloMat &m, std::string_view metric, bool unrooted = false);
+
+/**
+ * @brief Distances between all pairs of K trees with the same leaves
+ * @param vs Phylo2Vec vectors
+ * @param metric "robinson_foulds" or "kendall_colijn" (topological, rooted trees only)
+ * @param unrooted if true, compare the trees as unrooted
+ * @param numThreads number of threads (0 = all hardware threads)
+ * @return Matrix K x K distance matrix
+ * @throws std::invalid_argument if the metric is invalid or does not support unrooted trees,
+ * or if the trees have different numbers of leaves
+ */
+Matrix pairwiseTreeDistances(const std::vector<PhyloVec> &vs, std::string_view metric,
+                             bool unrooted = false, unsigned int numThreads = 0);
+
+/**
+ * @brief Distances between all pairs of K trees with the same leaves and branch lengths
+ * @param ms Phylo2Mat matrices
+ * @param metric "robinson_foulds" (ignores branch lengths) or "kendall_colijn"
+ * @param lambda weight of the branch lengths in the Kendall-Colijn distance, in [0, 1]
+ * @param unrooted if true, compare the trees as unrooted
+ * @param numThreads number of threads (0 = all hardware threads)
+ * @return Matrix K x K distance matrix
+ * @throws std::invalid_argument as the PhyloVec version, or if lambda is not in [0, 1]
+ */
+Matrix pairwiseTreeDistances(const std::vector<PhyloMat> &ms, std::string_view metric,
+                             double lambda = 0, bool unrooted = false,
+                             unsigned int numThreads = 0);
+
+#endif  // PAIRWISE_HPP
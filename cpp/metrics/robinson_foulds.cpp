@@ -0,0 +1,215 @@
+#include "robinson_foulds.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#include "../base/to_newick.hpp"
+#include "../utils/parallel.hpp"
+#include "../utils/random.hpp"
+
+// Seed of the leaf hashes (fixed, so that hashes are comparable across calls)
+static constexpr uint64_t SPLIT_HASH_SEED = 0x5EED5B17;
+
+// On x86-64 with GCC, also compile the bitset kernel with the POPCNT instruction
+// (not in the baseline instruction set) and pick the version at load time
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define POPCOUNT_CLONES __attribute__((target_clones("popcnt", "default")))
+#else
+#define POPCOUNT_CLONES
+#endif
+
+static std::vector<uint64_t> getLeafHashes(size_t numLeaves) {
+    CounterRNG rng(SPLIT_HASH_SEED);
+    std::vector<uint64_t> leafHashes(numLeaves);
+    for (auto &hash : leafHashes) {
+        hash = rng();
+    }
+    return leafHashes;
+}
+
+static std::vector<uint64_t> getSplitHashes(const PhyloVec &v,
+                                            const std::vector<uint64_t> &leafHashes,
+                                            bool unrooted) {
+    // A single leaf has no split (getPairs would still return the pair {0, 1})
+    if (v.empty()) {
+        return {};
+    }
+
+    const size_t numLeaves = v.size() + 1;
+
+    uint64_t allLeaves = 0;
+    for (size_t i = 0; i < numLeaves; ++i) {
+        allLeaves ^= leafHashes[i];
+    }
+
+    // Hash, size and whether it contains leaf 0 of the subtree last merged into each leaf
+    // (as in buildNewick, the pair (c1, c2) merges the subtree of c2 into that of c1)
+    std::vector<uint64_t> hashes(leafHashes.begin(), leafHashes.begin() + numLeaves);
+    std::vector<unsigned int> sizes(numLeaves, 1);
+    std::vector<bool> hasLeaf0(numLeaves, false);
+    hasLeaf0[0] = true;
+
+    std::vector<uint64_t> splits;
+    splits.reserve(numLeaves);
+
+    for (const auto &[c1, c2] : getPairs(v)) {
+        hashes[c1] ^= hashes[c2];
+        sizes[c1] += sizes[c2];
+        hasLeaf0[c1] = hasLeaf0[c1] || hasLeaf0[c2];
+
+        const size_t size = sizes[c1];
+        if (!unrooted) {
+            // Skip the root
+            if (size < numLeaves) {
+                splits.push_back(hashes[c1]);
+            }
+        } else if (size + 1 < numLeaves) {
+            // Skip the root and the complements of single leaves
+            splits.push_back(hasLeaf0[c1] ? allLeaves ^ hashes[c1] : hashes[c1]);
+        }
+    }
+
+    // The two subtrees of the root are the same split of an unrooted tree
+    std::sort(splits.begin(), splits.end());
+    splits.erase(std::unique(splits.begin(), splits.end()), splits.end());
+
+    return splits;
+}
+
+std::vector<uint64_t> getSplitHashes(const PhyloVec &v, bool unrooted) {
+    return getSplitHashes(v, getLeafHashes(v.size() + 1), unrooted);
+}
+
+// Number of common elements of two sorted ranges
+template <typename T>
+static size_t countCommon(const std::vector<T> &a, const std::vector<T> &b) {
+    size_t count = 0;
+    for (size_t i = 0, j = 0; i < a.size() && j < b.size();) {
+        if (a[i] < b[j]) {
+            ++i;
+        } else if (b[j] < a[i]) {
+            ++j;
+        } else {
+            ++count;
+            ++i;
+            ++j;
+        }
+    }
+    return count;
+}
+
+// Number of bits set in both bitsets of numWords words
+POPCOUNT_CLONES
+static size_t countCommonBits(const uint64_t *a, const uint64_t *b, size_t numWords) {
+    size_t count = 0;
+    for (size_t w = 0; w < numWords; ++w) {
+        count += __builtin_popcountll(a[w] & b[w]);
+    }
+    return count;
+}
+
+static void checkSameNumLeaves(size_t numLeaves1, size_t numLeaves2) {
+    if (numLeaves1 != numLeaves2) {
+        std::ostringstream oss;
+        oss << "Trees must have the same number of leaves (got " << numLeaves1 << " and "
+            << numLeaves2 << ")";
+        throw std::invalid_argument(oss.str());
+    }
+}
+
+unsigned int robinsonFoulds(const PhyloVec &v1, const PhyloVec &v2, bool unrooted) {
+    checkSameNumLeaves(v1.size() + 1, v2.size() + 1);
+
+    std::vector<uint64_t> leafHashes = getLeafHashes(v1.size() + 1);
+    std::vector<uint64_t> splits1 = getSplitHashes(v1, leafHashes, unrooted);
+    std::vector<uint64_t> splits2 = getSplitHashes(v2, leafHashes, unrooted);
+
+    return splits1.size() + splits2.size() - 2 * countCommon(splits1, splits2);
+}
+
+std::vector<unsigned int> robinsonFouldsAllPairs(const std::vector<PhyloVec> &vs, bool unrooted,
+                                                 unsigned int numThreads) {
+    const size_t numTrees = vs.size();
+    if (numTrees == 0) {
+        return {};
+    }
+
+    const size_t numLeaves = vs[0].size() + 1;
+    for (const auto &v : vs) {
+        checkSameNumLeaves(numLeaves, v.size() + 1);
+    }
+
+    // Splits of each tree
+    std::vector<uint64_t> leafHashes = getLeafHashes(numLeaves);
+    std::vector<std::vector<uint64_t>> splits(numTrees);
+    parallelFor(numTrees, numThreads, [&](size_t t, unsigned int) {
+        splits[t] = getSplitHashes(vs[t], leafHashes, unrooted);
+    });
+
+    // Global numbering of the splits shared by several trees
+    // (the others never count as common, e.g., most large clusters of random trees)
+    std::vector<uint64_t> allSplits;
+    for (const auto &treeSplits : splits) {
+        allSplits.insert(allSplits.end(), treeSplits.begin(), treeSplits.end());
+    }
+    std::sort(allSplits.begin(), allSplits.end());
+
+    std::vector<uint64_t> dictionary;
+    for (size_t i = 0; i < allSplits.size();) {
+        size_t j = i + 1;
+        while (j < allSplits.size() && allSplits[j] == allSplits[i]) {
+            ++j;
+        }
+        if (j - i > 1) {
+            dictionary.push_back(allSplits[i]);
+        }
+        i = j;
+    }
+    allSplits = std::vector<uint64_t>();
+
+    std::vector<std::vector<unsigned int>> ids(numTrees);
+    parallelFor(numTrees, numThreads, [&](size_t t, unsigned int) {
+        for (uint64_t hash : splits[t]) {
+            auto it = std::lower_bound(dictionary.begin(), dictionary.end(), hash);
+            if (it != dictionary.end() && *it == hash) {
+                ids[t].push_back(it - dictionary.begin());
+            }
+        }
+    });
+
+    size_t maxShared = 0;
+    for (const auto &treeIds : ids) {
+        maxShared = std::max(maxShared, treeIds.size());
+    }
+
+    // Bitsets are worth it if a bitset is shorter than a list of split numbers
+    const size_t numWords = (dictionary.size() + 63) / 64;
+    const bool useBitsets = numWords <= maxShared;
+
+    std::vector<uint64_t> bitsets;
+    if (useBitsets) {
+        bitsets.assign(numTrees * numWords, 0);
+        parallelFor(numTrees, numThreads, [&](size_t t, unsigned int) {
+            uint64_t *bitset = bitsets.data() + t * numWords;
+            for (unsigned int id : ids[t]) {
+                bitset[id / 64] |= uint64_t(1) << (id % 64);
+            }
+        });
+    }
+
+    // Each row fills its upper triangle and mirrors it
+    std::vector<unsigned int> distances(numTrees * numTrees, 0);
+    parallelFor(numTrees, numThreads, [&](size_t i, unsigned int) {
+        for (size_t j = i + 1; j < numTrees; ++j) {
+            size_t common = useBitsets ? countCommonBits(bitsets.data() + i * numWords,
+                                                         bitsets.data() + j * numWords, numWords)
+                                       : countCommon(ids[i], ids[j]);
+            unsigned int distance = splits[i].size() + splits[j].size() - 2 * common;
+            distances[i * numTrees + j] = distance;
+            distances[j * numTrees + i] = distance;
+        }
+    });
+
+    return distances;
+}
@@ -0,0 +1,58 @@
+#ifndef ROBINSON_FOULDS_HPP
+#define ROBINSON_FOULDS_HPP
+
+/**
+ * @file robinson_foulds.hpp
+ * @brief Robinson-Foulds distances between trees with the same leaves
+ *
+ * Each cluster (set of leaves below an internal node) is represented by a 64-bit hash:
+ * the XOR of a fixed random hash per leaf, so that the hash of a node
+ * is the XOR of the hashes of its children.
+ * Unrooted trees compare splits (bipartitions of the leaves):
+ * a cluster and its complement are the same split,
+ * represented by the side without leaf 0.
+ * Trivial clusters/splits (one leaf, or all leaves) are not counted.
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include "../base/core.hpp"
+
+/**
+ * @brief Hashes of the non-trivial clusters (rooted) or splits (unrooted) of a tree
+ * @param v Phylo2Vec vector
+ * @param unrooted if true, compare splits instead of clusters
+ * @return std::vector<uint64_t> sorted, distinct hashes
+ */
+std::vector<uint64_t> getSplitHashes(const PhyloVec &v, bool unrooted = false);
+
+/**
+ * @brief Robinson-Foulds distance between two trees with the same number of leaves
+ * (number of clusters/splits in only one of the trees)
+ * @param v1 first Phylo2Vec vector
+ * @param v2 second Phylo2Vec vector
+ * @param unrooted if true, compare splits instead of clusters
+ * @return unsigned int distance
+ * @throws std::invalid_argument if the trees have different numbers of leaves
+ */
+unsigned int robinsonFoulds(const PhyloVec &v1, const PhyloVec &v2, bool unrooted = false);
+
+/**
+ * @brief Robinson-Foulds distances between all pairs of K trees
+ * The splits of each tree are computed once and numbered globally.
+ * If there are few distinct splits overall (e.g., trees of a posterior sample),
+ * each tree becomes a bitset over them and a pair is compared with AND + popcount;
+ * otherwise, the sorted split numbers of the two trees are merged.
+ * Rows of the output are filled in parallel.
+ * @param vs Phylo2Vec vectors, all with the same number of leaves
+ * @param unrooted if true, compare splits instead of clusters
+ * @param numThreads number of threads (0 = all hardware threads)
+ * @return std::vector<unsigned int> row-major K x K distance matrix
+ * @throws std::invalid_argument if the trees have different numbers of leaves
+ */
+std::vector<unsigned int> robinsonFouldsAllPairs(const std::vector<PhyloVec> &vs,
+                                                 bool unrooted = false,
+                                                 unsigned int numThreads = 0);
+
+#endif  // ROBINSON_FOULDS_HPP
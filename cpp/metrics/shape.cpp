@@ -0,0 +1,149 @@
+#include "shape.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "../base/to_newick.hpp"
+#include "../utils/avl.hpp"
+#include "../utils/parallel.hpp"
+
+// Scratch space of the shape statistics of one tree, reused across trees
+struct ShapeWorkspace {
+    AVLTree tree;
+    Pairs pairs;
+    // Number of leaves and height of the subtree last merged into each leaf
+    std::vector<unsigned int> sizes;
+    std::vector<unsigned int> heights;
+    // Depth of the subtree last merged into each leaf (only needed for depth counts)
+    std::vector<unsigned int> depths;
+    // Copy of a vector of a contiguous block
+    PhyloVec v;
+};
+
+// Shape statistics of a tree, and its depth counts if depthCounts is not null
+// (numLeaves entries, overwritten)
+static ShapeStats getShapeStats(const PhyloVec &v, ShapeWorkspace &ws,
+                                unsigned int *depthCounts) {
+    const unsigned int numLeaves = v.size() + 1;
+
+    // A single leaf (getPairs would still return the pair {0, 1})
+    if (v.empty()) {
+        if (depthCounts) {
+            depthCounts[0] = 1;
+        }
+        return {0, 0, 0, 0};
+    }
+
+    getPairs(v, ws.tree, ws.pairs);
+
+    ws.sizes.assign(numLeaves, 1);
+    ws.heights.assign(numLeaves, 0);
+
+    ShapeStats stats = {0, 0, 0, 0};
+    for (const auto &[c1, c2] : ws.pairs) {
+        const unsigned int size1 = ws.sizes[c1], size2 = ws.sizes[c2];
+        stats.sackin += size1 + size2;
+        stats.colless += size1 > size2 ? size1 - size2 : size2 - size1;
+        stats.numCherries += size1 == 1 && size2 == 1;
+        ws.sizes[c1] = size1 + size2;
+        ws.heights[c1] = std::max(ws.heights[c1], ws.heights[c2]) + 1;
+    }
+    stats.height = ws.heights[0];
+
+    if (depthCounts) {
+        std::fill(depthCounts, depthCounts + numLeaves, 0);
+
+        // Undo the merges from the root down: before pair (c1, c2) is undone,
+        // the slot of c1 holds the depth of their parent, which becomes the depth of both children
+        ws.depths.assign(numLeaves, 0);
+        for (size_t i = ws.pairs.size(); i-- > 0;) {
+            const auto &[c1, c2] = ws.pairs[i];
+            ws.depths[c2] = ++ws.depths[c1];
+        }
+        for (unsigned int i = 0; i < numLeaves; ++i) {
+            ++depthCounts[ws.depths[i]];
+        }
+    }
+
+    return stats;
+}
+
+ShapeStats getShapeStats(const PhyloVec &v) {
+    ShapeWorkspace ws;
+    return getShapeStats(v, ws, nullptr);
+}
+
+std::vector<unsigned int> getLeafDepthCounts(const PhyloVec &v) {
+    ShapeWorkspace ws;
+    std::vector<unsigned int> depthCounts(v.size() + 1);
+    getShapeStats(v, ws, depthCounts.data());
+    return depthCounts;
+}
+
+// Fill the statistics of numTrees trees, where getVector(t, ws) returns the vector of tree t
+// and numLeaves(t) its number of leaves
+template <typename GetVector, typename GetNumLeaves>
+static ShapeStatsBatch getShapeStatsBatch(size_t numTrees, GetVector getVector,
+                                          GetNumLeaves getNumLeaves, bool withDepthCounts,
+                                          unsigned int numThreads) {
+    ShapeStatsBatch batch;
+    batch.sackin.resize(numTrees);
+    batch.colless.resize(numTrees);
+    batch.numCherries.resize(numTrees);
+    batch.height.resize(numTrees);
+
+    if (withDepthCounts) {
+        batch.depthOffsets.resize(numTrees + 1);
+        batch.depthOffsets[0] = 0;
+        for (size_t t = 0; t < numTrees; ++t) {
+            batch.depthOffsets[t + 1] = batch.depthOffsets[t] + getNumLeaves(t);
+        }
+        batch.depthCounts.resize(batch.depthOffsets[numTrees]);
+    }
+
+    numThreads = getNumThreads(numThreads);
+
+    // Per-thread scratch space
+    std::vector<ShapeWorkspace> workspaces(numThreads);
+
+    parallelFor(
+        numTrees, numThreads,
+        [&](size_t t, unsigned int thread) {
+            ShapeWorkspace &ws = workspaces[thread];
+            unsigned int *depthCounts =
+                withDepthCounts ? batch.depthCounts.data() + batch.depthOffsets[t] : nullptr;
+
+            ShapeStats stats = getShapeStats(getVector(t, ws), ws, depthCounts);
+
+            batch.sackin[t] = stats.sackin;
+            batch.colless[t] = stats.colless;
+            batch.numCherries[t] = stats.numCherries;
+            batch.height[t] = stats.height;
+        },
+        64);
+
+    return batch;
+}
+
+ShapeStatsBatch getShapeStatsBatch(const std::vector<PhyloVec> &vs, bool withDepthCounts,
+                                   unsigned int numThreads) {
+    return getShapeStatsBatch(
+        vs.size(), [&](size_t t, ShapeWorkspace &) -> const PhyloVec & { return vs[t]; },
+        [&](size_t t) { return vs[t].size() + 1; }, withDepthCounts, numThreads);
+}
+
+ShapeStatsBatch getShapeStatsBatch(const unsigned int *vs, size_t numTrees, size_t numLeaves,
+                                   bool withDepthCounts, unsigned int numThreads) {
+    if (numLeaves == 0) {
+        throw std::invalid_argument("Trees must have at least one leaf");
+    }
+
+    const size_t length = numLeaves - 1;
+    return getShapeStatsBatch(
+        numTrees,
+        [&](size_t t, ShapeWorkspace &ws) -> const PhyloVec & {
+            ws.v.assign(vs + t * length, vs + (t + 1) * length);
+            return ws.v;
+        },
+        [&](size_t) { return numLeaves; }, withDepthCounts, numThreads);
+}
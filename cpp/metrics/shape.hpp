@@ -0,0 +1,87 @@
+#ifndef SHAPE_HPP
+#define SHAPE_HPP
+
+/**
+ * @file shape.hpp
+ * @brief Tree shape (balance) statistics
+ *
+ * The depth of a leaf is its number of edges to the root.
+ * - Sackin index: sum of the depths of the leaves
+ * - Colless index: sum over internal nodes of |leaves(left) - leaves(right)|
+ * - cherries: internal nodes whose two children are leaves
+ * - height: maximum depth of a leaf
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include "../base/core.hpp"
+
+/**
+ * @brief Shape statistics of a tree
+ */
+struct ShapeStats {
+    uint64_t sackin;
+    uint64_t colless;
+    unsigned int numCherries;
+    unsigned int height;
+};
+
+/**
+ * @brief Shape statistics of many trees, as one array per statistic
+ * depthCounts[depthOffsets[t] + d] is the number of leaves of tree t at depth d,
+ * for d in [0, number of leaves of tree t) (empty if depth counts were not requested).
+ */
+struct ShapeStatsBatch {
+    std::vector<uint64_t> sackin;
+    std::vector<uint64_t> colless;
+    std::vector<unsigned int> numCherries;
+    std::vector<unsigned int> height;
+    std::vector<size_t> depthOffsets;
+    std::vector<unsigned int> depthCounts;
+
+    size_t size() const { return sackin.size(); }
+};
+
+/**
+ * @brief Shape statistics of a tree in one pass over its pairs (see getPairs):
+ * each pair merges two subtrees, whose number of leaves and height are tracked
+ * in the slot of their smallest leaf.
+ * @param v Phylo2Vec vector
+ * @return ShapeStats statistics
+ */
+ShapeStats getShapeStats(const PhyloVec &v);
+
+/**
+ * @brief Number of leaves at each depth
+ * @param v Phylo2Vec vector
+ * @return std::vector<unsigned int> counts, indexed by depth in [0, v.size() + 1)
+ */
+std::vector<unsigned int> getLeafDepthCounts(const PhyloVec &v);
+
+/**
+ * @brief Shape statistics of many trees in parallel
+ * Each thread reuses its own scratch space, so no memory is allocated per tree.
+ * @param vs Phylo2Vec vectors
+ * @param withDepthCounts if true, also count the leaves at each depth
+ * @param numThreads number of threads (0 = all hardware threads)
+ * @return ShapeStatsBatch statistics, in the same order as vs
+ */
+ShapeStatsBatch getShapeStatsBatch(const std::vector<PhyloVec> &vs, bool withDepthCounts = false,
+                                   unsigned int numThreads = 0);
+
+/**
+ * @brief Shape statistics of a contiguous block of vectors of trees with the same leaves
+ * (e.g., a row-major numTrees x (numLeaves - 1) array)
+ * @param vs first entry of the first vector
+ * @param numTrees number of vectors
+ * @param numLeaves number of leaves of each tree
+ * @param withDepthCounts if true, also count the leaves at each depth
+ * @param numThreads number of threads (0 = all hardware threads)
+ * @return ShapeStatsBatch statistics, in the same order as vs
+ * @throws std::invalid_argument if numLeaves is 0
+ */
+ShapeStatsBatch getShapeStatsBatch(const unsigned int *vs, size_t numTrees, size_t numLeaves,
+                                   bool withDepthCounts = false, unsigned int numThreads = 0);
+
+#endif  // SHAPE_HPP
@@ -0,0 +1,355 @@
+#include "dynamic_tree.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#include "../base/to_newick.hpp"
+#include "../base/to_vector.hpp"
+
+DynamicTree::DynamicTree(const PhyloVec &v, std::uint64_t seed)
+    : root(NONE), leafRoot(NONE), rng(seed), upToDate(false), changedOffset(0) {
+    const unsigned int numLeaves = v.size() + 1;
+    const unsigned int numNodes = 2 * numLeaves - 1;
+
+    for (unsigned int i = 0; i < numNodes; ++i) {
+        newNode();
+    }
+
+    // Children of internal nodes (as in buildNewick)
+    Pairs internalChildren;
+    root = ::getChildren(getPairs(v), numLeaves, internalChildren);
+    for (unsigned int i = 0; i + 1 < numLeaves; ++i) {
+        const NodeId node = numLeaves + i;
+        children[node] = internalChildren[i];
+        parent[children[node][0]] = parent[children[node][1]] = node;
+    }
+
+    // Leaves in label order
+    for (unsigned int i = 0; i < numLeaves; ++i) {
+        leafRoot = treapMerge(leafRoot, i);
+    }
+
+    rebuild();
+    changedOffset = this->v.size();
+}
+
+DynamicTree::NodeId DynamicTree::newNode() {
+    NodeId node;
+    if (!freeNodes.empty()) {
+        node = freeNodes.back();
+        freeNodes.pop_back();
+    } else {
+        node = parent.size();
+        parent.push_back(NONE);
+        children.push_back({NONE, NONE});
+        treapLeft.push_back(NONE);
+        treapRight.push_back(NONE);
+        treapParent.push_back(NONE);
+        treapSize.push_back(1);
+        priority.push_back(0);
+    }
+
+    parent[node] = NONE;
+    children[node] = {NONE, NONE};
+    treapLeft[node] = treapRight[node] = treapParent[node] = NONE;
+    treapSize[node] = 1;
+    priority[node] = rng();
+
+    return node;
+}
+
+void DynamicTree::checkLeafLabel(unsigned int leaf, size_t numLabels) const {
+    if (leaf >= numLabels) {
+        std::ostringstream oss;
+        oss << "Leaf " << leaf << " is out of range (number of labels: " << numLabels << ")";
+        throw std::out_of_range(oss.str());
+    }
+}
+
+void DynamicTree::markChanged(unsigned int leaf) {
+    // Entry leaf - 1 describes leaf "leaf"; earlier entries only describe smaller labels
+    changedOffset = std::min<size_t>(changedOffset, leaf > 0 ? leaf - 1 : 0);
+    upToDate = false;
+}
+
+void DynamicTree::treapUpdate(NodeId node) {
+    treapSize[node] = 1 + (treapLeft[node] == NONE ? 0 : treapSize[treapLeft[node]]) +
+                      (treapRight[node] == NONE ? 0 : treapSize[treapRight[node]]);
+}
+
+void DynamicTree::treapSplit(NodeId node, size_t count, NodeId &left, NodeId &right) {
+    // The first count leaves go to left, the others to right
+    if (node == NONE) {
+        left = right = NONE;
+        return;
+    }
+
+    const size_t leftSize = treapLeft[node] == NONE ? 0 : treapSize[treapLeft[node]];
+    if (count <= leftSize) {
+        NodeId subtree;
+        treapSplit(treapLeft[node], count, left, subtree);
+        treapLeft[node] = subtree;
+        if (subtree != NONE) {
+            treapParent[subtree] = node;
+        }
+        right = node;
+    } else {
+        NodeId subtree;
+        treapSplit(treapRight[node], count - leftSize - 1, subtree, right);
+        treapRight[node] = subtree;
+        if (subtree != NONE) {
+            treapParent[subtree] = node;
+        }
+        left = node;
+    }
+    treapUpdate(node);
+
+    if (left != NONE) {
+        treapParent[left] = NONE;
+    }
+    if (right != NONE) {
+        treapParent[right] = NONE;
+    }
+}
+
+DynamicTree::NodeId DynamicTree::treapMerge(NodeId left, NodeId right) {
+    if (left == NONE) {
+        return right;
+    }
+    if (right == NONE) {
+        return left;
+    }
+
+    if (priority[left] > priority[right]) {
+        NodeId subtree = treapMerge(treapRight[left], right);
+        treapRight[left] = subtree;
+        treapParent[subtree] = left;
+        treapUpdate(left);
+        return left;
+    } else {
+        NodeId subtree = treapMerge(left, treapLeft[right]);
+        treapLeft[right] = subtree;
+        treapParent[subtree] = right;
+        treapUpdate(right);
+        return right;
+    }
+}
+
+void DynamicTree::treapInsert(NodeId node, size_t position) {
+    NodeId left, right;
+    treapSplit(leafRoot, position, left, right);
+    leafRoot = treapMerge(treapMerge(left, node), right);
+    treapParent[leafRoot] = NONE;
+}
+
+void DynamicTree::treapErase(NodeId node) {
+    NodeId subtree = treapMerge(treapLeft[node], treapRight[node]);
+    NodeId p = treapParent[node];
+    if (subtree != NONE) {
+        treapParent[subtree] = p;
+    }
+
+    if (p == NONE) {
+        leafRoot = subtree;
+    } else {
+        (treapLeft[p] == node ? treapLeft[p] : treapRight[p]) = subtree;
+        for (; p != NONE; p = treapParent[p]) {
+            treapUpdate(p);
+        }
+    }
+}
+
+DynamicTree::NodeId DynamicTree::getLeafNode(unsigned int leaf) const {
+    checkLeafLabel(leaf, getNumLeaves());
+
+    NodeId node = leafRoot;
+    size_t count = leaf;
+    while (true) {
+        const size_t leftSize = treapLeft[node] == NONE ? 0 : treapSize[treapLeft[node]];
+        if (count < leftSize) {
+            node = treapLeft[node];
+        } else if (count == leftSize) {
+            return node;
+        } else {
+            count -= leftSize + 1;
+            node = treapRight[node];
+        }
+    }
+}
+
+unsigned int DynamicTree::getLeafLabel(NodeId node) const {
+    if (node >= parent.size() || !isLeaf(node) || (node != root && parent[node] == NONE)) {
+        std::ostringstream oss;
+        oss << "Node " << node << " is not a leaf";
+        throw std::invalid_argument(oss.str());
+    }
+
+    unsigned int label = treapLeft[node] == NONE ? 0 : treapSize[treapLeft[node]];
+    for (NodeId p = treapParent[node]; p != NONE; node = p, p = treapParent[p]) {
+        if (treapRight[p] == node) {
+            label += 1 + (treapLeft[p] == NONE ? 0 : treapSize[treapLeft[p]]);
+        }
+    }
+    return label;
+}
+
+DynamicTree::NodeId DynamicTree::addLeafAbove(unsigned int leaf, NodeId sister) {
+    checkLeafLabel(leaf, getNumLeaves() + 1);
+
+    const NodeId leafNode = newNode();
+    const NodeId node = newNode();
+
+    // node takes the place of sister, with children sister and the new leaf
+    const NodeId p = parent[sister];
+    if (p == NONE) {
+        root = node;
+    } else {
+        (children[p][0] == sister ? children[p][0] : children[p][1]) = node;
+    }
+    parent[node] = p;
+    children[node] = {sister, leafNode};
+    parent[sister] = parent[leafNode] = node;
+
+    treapInsert(leafNode, leaf);
+    markChanged(leaf);
+
+    return leafNode;
+}
+
+void DynamicTree::addLeaf(unsigned int leaf, unsigned int pos) {
+    const size_t numLeaves = getNumLeaves();
+    checkLeafLabel(leaf, numLeaves + 1);
+    if (pos > 2 * numLeaves - 2) {
+        std::ostringstream oss;
+        oss << "Branch " << pos << " is out of range (number of branches: " << 2 * numLeaves - 1
+            << ")";
+        throw std::out_of_range(oss.str());
+    }
+
+    NodeId sister;
+    if (pos < numLeaves) {
+        // Pendant branch of leaf pos
+        sister = getLeafNode(pos);
+    } else {
+        // Branch above the (pos - numLeaves)-th cherry of the vector
+        if (!upToDate) {
+            rebuild();
+        }
+        sister = cherryNodes[pos - numLeaves];
+    }
+
+    addLeafAbove(leaf, sister);
+}
+
+DynamicTree::NodeId DynamicTree::removeLeaf(unsigned int leaf) {
+    if (getNumLeaves() <= 2) {
+        throw std::invalid_argument("Cannot remove a leaf from a tree with two leaves");
+    }
+
+    const NodeId leafNode = getLeafNode(leaf);
+    const NodeId node = parent[leafNode];
+    const NodeId sister = children[node][0] == leafNode ? children[node][1] : children[node][0];
+
+    // sister takes the place of its parent
+    const NodeId p = parent[node];
+    if (p == NONE) {
+        root = sister;
+    } else {
+        (children[p][0] == node ? children[p][0] : children[p][1]) = sister;
+    }
+    parent[sister] = p;
+
+    treapErase(leafNode);
+
+    for (NodeId removed : {leafNode, node}) {
+        parent[removed] = NONE;
+        children[removed] = {NONE, NONE};
+        freeNodes.push_back(removed);
+    }
+
+    markChanged(leaf);
+
+    return sister;
+}
+
+void DynamicTree::rebuild() {
+    const unsigned int numLeaves = getNumLeaves();
+    const unsigned int numCherries = numLeaves - 1;
+
+    // Label of each leaf: in-order traversal of the treap
+    labels.assign(parent.size(), 0);
+    stack.clear();
+    unsigned int label = 0;
+    for (NodeId node = leafRoot; node != NONE || !stack.empty();) {
+        if (node != NONE) {
+            stack.push_back(node);
+            node = treapLeft[node];
+        } else {
+            node = stack.back();
+            stack.pop_back();
+            labels[node] = label++;
+            node = treapRight[node];
+        }
+    }
+
+    // Label internal nodes numLeaves, ... in reverse pre-order, so that parents follow their
+    // children (as sortByParent expects)
+    postOrder.clear();
+    stack.assign(1, root);
+    while (!stack.empty()) {
+        NodeId node = stack.back();
+        stack.pop_back();
+        if (!isLeaf(node)) {
+            postOrder.push_back(node);
+            stack.push_back(children[node][0]);
+            stack.push_back(children[node][1]);
+        }
+    }
+    std::reverse(postOrder.begin(), postOrder.end());
+
+    for (unsigned int i = 0; i < numCherries; ++i) {
+        labels[postOrder[i]] = numLeaves + i;
+    }
+
+    Ancestry &ancestry = ws.ancestry;
+    ancestry.resize(numCherries);
+    for (unsigned int i = 0; i < numCherries; ++i) {
+        const auto &[c1, c2] = children[postOrder[i]];
+        ancestry[i] = {int(labels[c1]), int(labels[c2]), int(numLeaves + i)};
+    }
+
+    // Cherries in the order of the vector
+    orderCherries(ancestry, order1, ws);
+    orderCherriesNoParents(ancestry, order2, ws);
+    buildVector(ancestry, v, ws);
+
+    cherryNodes.resize(numCherries);
+    for (unsigned int i = 0; i < numCherries; ++i) {
+        cherryNodes[i] = postOrder[order1[order2[i]]];
+    }
+
+    upToDate = true;
+}
+
+const PhyloVec &DynamicTree::getVector() {
+    if (!upToDate) {
+        rebuild();
+    }
+    changedOffset = v.size();
+    return v;
+}
+
+size_t DynamicTree::getChangedOffset() const {
+    return std::min(changedOffset, getNumLeaves() - 1);
+}
+
+size_t DynamicTree::getChangedSuffix(PhyloVec &suffix) {
+    const size_t offset = getChangedOffset();
+    if (!upToDate) {
+        rebuild();
+    }
+    suffix.assign(v.begin() + offset, v.end());
+    changedOffset = v.size();
+    return offset;
+}
@@ -0,0 +1,156 @@
+#ifndef DYNAMIC_TREE_HPP
+#define DYNAMIC_TREE_HPP
+
+/**
+ * @file dynamic_tree.hpp
+ * @brief Mutable tree supporting leaf insertions and removals without rebuilding the vector
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include "../base/core.hpp"
+#include "../base/workspace.hpp"
+#include "../utils/random.hpp"
+
+/**
+ * @brief Tree built from a Phylo2Vec vector, edited leaf by leaf
+ *
+ * Nodes are stored with parent and child links and keep a stable handle (NodeId)
+ * across edits. Leaf labels are ranks in an implicit treap over the leaves,
+ * so inserting a leaf at label l (shifting the labels >= l) above a given node,
+ * or removing one, takes O(log n) expected time. Inserting above a branch of the
+ * vector (addLeaf) is only O(log n) for the branch above a leaf: the branch above
+ * an internal node is found from the order of the cherries, which costs an
+ * O(n log n) rebuild if the tree changed since the last one.
+ *
+ * The vector is only rebuilt (in O(n log n)) when requested, after any number of edits.
+ * An edit of label l changes no entry before l - 1, as those only describe
+ * the leaves with smaller labels, so callers can fetch only the changed suffix.
+ */
+class DynamicTree {
+   public:
+    typedef unsigned int NodeId;
+
+    explicit DynamicTree(const PhyloVec &v, std::uint64_t seed = 0);
+
+    size_t getNumLeaves() const { return leafRoot == NONE ? 0 : treapSize[leafRoot]; }
+    NodeId getRoot() const { return root; }
+
+    /**
+     * @brief Node of the leaf with a given label, in O(log n)
+     * @throws std::out_of_range if there is no such leaf
+     */
+    NodeId getLeafNode(unsigned int leaf) const;
+
+    /**
+     * @brief Label of a leaf node, in O(log n)
+     * @throws std::invalid_argument if the node is not a leaf
+     */
+    unsigned int getLeafLabel(NodeId node) const;
+
+    bool isLeaf(NodeId node) const { return children[node][0] == NONE; }
+    NodeId getParent(NodeId node) const { return parent[node]; }
+    const std::array<NodeId, 2> &getChildren(NodeId node) const { return children[node]; }
+
+    /**
+     * @brief Add a leaf as in addLeaf(v, leaf, pos): a new leaf attached at branch pos
+     * of the current vector, then relabelled leaf (labels >= leaf are shifted by one)
+     * Attaching to a leaf (pos < number of leaves) takes O(log n);
+     * attaching above an internal node needs the order of the cherries of the vector,
+     * which is rebuilt first (in O(n log n)) if the tree changed since the last rebuild.
+     * Use addLeafAbove to attach above an internal node in O(log n).
+     * @param leaf label of the new leaf, in [0, number of leaves]
+     * @param pos branch of the current vector, in [0, 2 * number of leaves - 2]
+     * @throws std::out_of_range if leaf or pos is out of range
+     */
+    void addLeaf(unsigned int leaf, unsigned int pos);
+
+    /**
+     * @brief Add a leaf with label leaf (labels >= leaf are shifted by one)
+     * as the sister of any node, in O(log n)
+     * @param leaf label of the new leaf, in [0, number of leaves]
+     * @param sister node above which the leaf is attached
+     * @return NodeId node of the new leaf
+     * @throws std::out_of_range if leaf is out of range
+     */
+    NodeId addLeafAbove(unsigned int leaf, NodeId sister);
+
+    /**
+     * @brief Remove a leaf as in removeLeaf(v, leaf): its parent is replaced by its sister
+     * and labels > leaf are shifted down by one, in O(log n)
+     * @param leaf label of the leaf
+     * @return NodeId node of the sister of the leaf
+     * @throws std::out_of_range if there is no such leaf
+     * @throws std::invalid_argument if the tree only has two leaves
+     */
+    NodeId removeLeaf(unsigned int leaf);
+
+    /**
+     * @brief Vector of the current tree, rebuilt if the tree changed since the last call
+     */
+    const PhyloVec &getVector();
+
+    /**
+     * @brief Position of the first entry of the vector that may have changed
+     * since the last call to getVector or getChangedSuffix
+     * (size of the vector if nothing changed)
+     */
+    size_t getChangedOffset() const;
+
+    /**
+     * @brief Entries of the vector from getChangedOffset() on
+     * @param suffix output entries (overwritten)
+     * @return size_t position of the first entry of suffix in the vector
+     */
+    size_t getChangedSuffix(PhyloVec &suffix);
+
+   private:
+    static constexpr NodeId NONE = UINT32_MAX;
+
+    NodeId newNode();
+    void checkLeafLabel(unsigned int leaf, size_t numLabels) const;
+    void markChanged(unsigned int leaf);
+
+    // Implicit treap over the leaves, in label order
+    void treapUpdate(NodeId node);
+    void treapSplit(NodeId node, size_t count, NodeId &left, NodeId &right);
+    NodeId treapMerge(NodeId left, NodeId right);
+    void treapInsert(NodeId node, size_t position);
+    void treapErase(NodeId node);
+
+    // Rebuild the vector and the order of the cherries
+    void rebuild();
+
+    // Tree
+    NodeId root;
+    std::vector<NodeId> parent;
+    std::vector<std::array<NodeId, 2>> children;
+    std::vector<NodeId> freeNodes;
+
+    // Treap (indexed by leaf node)
+    NodeId leafRoot;
+    std::vector<NodeId> treapLeft;
+    std::vector<NodeId> treapRight;
+    std::vector<NodeId> treapParent;
+    std::vector<unsigned int> treapSize;
+    std::vector<std::uint64_t> priority;
+    CounterRNG rng;
+
+    // Vector as of the last rebuild, internal node of each cherry in the order of the vector,
+    // and first entry changed since the last call to getVector or getChangedSuffix
+    PhyloVec v;
+    std::vector<NodeId> cherryNodes;
+    bool upToDate;
+    size_t changedOffset;
+
+    // Scratch space of rebuild
+    ConversionWorkspace ws;
+    std::vector<unsigned int> labels;
+    std::vector<NodeId> stack;
+    std::vector<NodeId> postOrder;
+    std::vector<unsigned int> order1;
+    std::vector<unsigned int> order2;
+};
+
+#endif  // DYNAMIC_TREE_HPP
@@ -0,0 +1,129 @@
+#include "neighbourhood.hpp"
+
+#include <sstream>
+#include <stdexcept>
+
+#include "../base/to_newick.hpp"
+
+// Flag of a source that is a constant node rather than a rank
+static constexpr unsigned int CONSTANT = 1u << 31;
+
+void Neighbourhood::setRank(unsigned int rank, const Pair &value) {
+    pairs[rankPosition[rank]] = value;
+    for (unsigned int t = dependentOffsets[rank]; t < dependentOffsets[rank + 1]; ++t) {
+        pairs[dependents[t]][0] = value[0];
+    }
+}
+
+void Neighbourhood::forEach(const PhyloVec &v, size_t index, const NeighbourCallback &callback) {
+    forEach(v, index, 0, 2 * index + 1, callback);
+}
+
+void Neighbourhood::forEach(const PhyloVec &v, size_t index, unsigned int begin,
+                            unsigned int end, const NeighbourCallback &callback) {
+    const size_t k = v.size();
+    if (index >= k) {
+        std::ostringstream oss;
+        oss << "Index " << index << " is out of range (size of v: " << k << ")";
+        throw std::out_of_range(oss.str());
+    }
+    if (begin > end || end > 2 * index + 1) {
+        std::ostringstream oss;
+        oss << "Proposals [" << begin << ", " << end << ") are out of range (index " << index
+            << " has " << 2 * index + 1 << ")";
+        throw std::out_of_range(oss.str());
+    }
+    if (begin == end) {
+        return;
+    }
+
+    // v[0] is always 0
+    if (index == 0) {
+        getPairs(v, tree, pairs);
+        callback(0, pairs);
+        return;
+    }
+
+    const unsigned int i = index;
+
+    prefixVector.assign(v.begin(), v.begin() + i);
+    getPairs(prefixVector, tree, prefix);
+
+    // Replay the insertions of the entries > i on the ranks 0, ..., i of the list after entry i
+    source.resize(k);
+    tree.clear();
+    tree.reserve(k);
+    for (unsigned int r = 0; r <= i; ++r) {
+        source[r] = r;
+        tree.insert(r, {r, 0});
+    }
+    for (unsigned int m = i + 1; m < k; ++m) {
+        if (v[m] <= m) {
+            source[m] = CONSTANT | v[m];
+            tree.insert(0, {m, 0});
+        } else {
+            unsigned int lookupIndex = v[m] - m - 1;
+            source[m] = source[tree.lookup(tree.getRoot(), lookupIndex)[0]];
+            tree.insert(lookupIndex + 1, {m, 0});
+        }
+    }
+    tree.getPairs(order);
+
+    // Output positions of the ranks, and pairs of the entries > i (up to their first node)
+    pairs.resize(k);
+    rankPosition.resize(i + 1);
+    dependentOffsets.assign(i + 2, 0);
+    for (unsigned int t = 0; t < k; ++t) {
+        const unsigned int element = order[t][0];
+        if (element <= i) {
+            rankPosition[element] = t;
+        } else {
+            pairs[t] = {source[element] & ~CONSTANT, element + 1};
+            if (!(source[element] & CONSTANT)) {
+                ++dependentOffsets[source[element] + 1];
+            }
+        }
+    }
+    for (unsigned int r = 0; r <= i; ++r) {
+        dependentOffsets[r + 1] += dependentOffsets[r];
+    }
+    dependents.resize(dependentOffsets[i + 1]);
+    dependentNext.assign(dependentOffsets.begin(), dependentOffsets.end() - 1);
+    for (unsigned int t = 0; t < k; ++t) {
+        const unsigned int element = order[t][0];
+        if (element > i && !(source[element] & CONSTANT)) {
+            dependents[dependentNext[source[element]]++] = t;
+        }
+    }
+
+    // j <= i: the pair (j, i + 1) is inserted at rank 0, before the prefix
+    unsigned int j = begin;
+    if (j <= i) {
+        for (unsigned int r = 1; r <= i; ++r) {
+            setRank(r, prefix[r - 1]);
+        }
+        for (; j <= i && j < end; ++j) {
+            setRank(0, {j, i + 1});
+            callback(j, pairs);
+        }
+    } else {
+        // Starting past i: set the ranks that the first step below does not rewrite
+        // (the prefix before and after the pair of entry i)
+        const unsigned int rank = j - i;
+        for (unsigned int r = 0; r + 1 < rank; ++r) {
+            setRank(r, prefix[r]);
+        }
+        for (unsigned int r = rank + 1; r <= i; ++r) {
+            setRank(r, prefix[r - 1]);
+        }
+    }
+
+    // j > i: the pair (prefix[j - i - 1][0], i + 1) is inserted at rank j - i,
+    // so it swaps places with the previous prefix pair
+    for (; j < end; ++j) {
+        const unsigned int rank = j - i;
+        setRank(rank - 1, prefix[rank - 1]);
+        setRank(rank, {prefix[rank - 1][0], i + 1});
+        callback(j, pairs);
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef NEIGHBOURHOOD_HPP
+#define NEIGHBOURHOOD_HPP
+
+/**
+ * @file neighbourhood.hpp
+ * @brief Enumeration of the trees obtained by changing one entry of a vector
+ */
+
+#include <functional>
+#include <vector>
+
+#include "../base/core.hpp"
+#include "../utils/avl.hpp"
+
+/**
+ * @brief Callback receiving each proposal: the new value j of the entry,
+ * and the pairs of the vector with that value (see getPairs).
+ * The pairs are only valid during the call.
+ */
+typedef std::function<void(unsigned int, const Pairs &)> NeighbourCallback;
+
+/**
+ * @brief Pairs of the 2i + 1 vectors v' with v'[i] = j (j in [0, 2i]) and v' = v elsewhere
+ *
+ * makeTree inserts one pair per entry, at a position that only depends on that entry.
+ * The pairs of entries < i (the prefix) are shared by all proposals, and the final position
+ * of the pairs of entries > i does not depend on v[i]: the list after entry i fills
+ * the remaining positions in order. Each pair of entry m > i copies its first node from
+ * a constant or from the first node of the pair at a fixed rank of the list after entry i.
+ *
+ * These positions and sources are computed once per index in O(n log n).
+ * Going from proposal j to j + 1 moves the pair of entry i by at most one rank,
+ * so only the pairs depending on the one or two changed ranks are rewritten.
+ * Scratch space is kept across calls, so one object can sweep all indices of a vector.
+ */
+class Neighbourhood {
+   public:
+    /**
+     * @brief Call callback on each proposal v'[index] = j, for j = 0, ..., 2 * index
+     * (including the current value of v[index])
+     * @param v Phylo2Vec vector
+     * @param index entry to change
+     * @param callback function called with (j, pairs of v')
+     * @throws std::out_of_range if index >= v.size()
+     */
+    void forEach(const PhyloVec &v, size_t index, const NeighbourCallback &callback);
+
+    /**
+     * @brief Call callback on the proposals v'[index] = j for j in [begin, end) only
+     * (e.g., a share of the proposals of one index for each thread)
+     * @throws std::out_of_range if index >= v.size() or the range is not in [0, 2 * index + 1)
+     */
+    void forEach(const PhyloVec &v, size_t index, unsigned int begin, unsigned int end,
+                 const NeighbourCallback &callback);
+
+   private:
+    // Set the pair at a rank of the list after entry index
+    void setRank(unsigned int rank, const Pair &value);
+
+    AVLTree tree;
+    // Entries < index of v, and their pairs
+    PhyloVec prefixVector;
+    Pairs prefix;
+    // Output pairs of the current proposal
+    Pairs pairs;
+    // Element at each output position: a rank of the list after entry index (<= index),
+    // or an entry m > index
+    Pairs order;
+    // Source of the first node of each element: a rank, or a constant (flagged)
+    std::vector<unsigned int> source;
+    // Output position of each rank, and positions of the pairs copying its first node
+    std::vector<unsigned int> rankPosition;
+    std::vector<unsigned int> dependentOffsets;
+    std::vector<unsigned int> dependents;
+    // Next free slot of each rank in dependents, while filling it
+    std::vector<unsigned int> dependentNext;
+};
+
+#endif  // NEIGHBOURHOOD_HPP
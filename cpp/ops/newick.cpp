@@ -2,25 +2,28 @@
 
 void removeAnnotations(std::string &newick, const char delimiter,
                        int keepDelimiter) {
-    int openIdx = -1;
+    // Compact the string in place (single pass):
+    // chars are read at i and written at w
+    size_t w = 0;
+    // Write position where the current annotation starts
+    size_t openIdx = std::string::npos;
     for (size_t i = 0; i < newick.size(); ++i) {
         char c = newick[i];
         // c is an end delimiter and the reading frame is open
-        // erase what is between ')' and c
+        // drop what is between the delimiter and c
         // (i.e., the annotation of interest)
-        if (endDelimiters.find(c) != std::string::npos && openIdx != -1) {
-            size_t length = i - openIdx;
-            newick.erase(openIdx, length);
-            // Roll back i to the index before the substring
-            i -= length;
+        if (endDelimiters.find(c) != std::string::npos && openIdx != std::string::npos) {
+            w = openIdx;
             // close the reading frame
-            openIdx = -1;
+            openIdx = std::string::npos;
         }
+        newick[w++] = c;
         // c is a delimiter --> open the reading frame
         if (c == delimiter) {
-            openIdx = i + keepDelimiter;
+            openIdx = w - 1 + keepDelimiter;
         }
     }
+    newick.resize(w);
 }
 
 void removeParentLabels(std::string &newick) {
@@ -46,12 +49,13 @@ Converter toIntNewick(std::string_view strNewick) {
             // substring between start and end delimiter (= a taxon)
             std::string_view taxon = strNewick.substr(openIdx, i - openIdx);
 
-            // Add the taxon to the mapping
-            result.mapping.push_back(taxon);
-
             // Instead of a taxon, add the next int to the int Newick
+            // (so that mapping[leaf] = taxon)
             result.intNewick += std::to_string(result.mapping.size());
 
+            // Add the taxon to the mapping
+            result.mapping.push_back(taxon);
+
             // Reset
             openIdx = -1;
         }
@@ -1,3 +1,6 @@
+#ifndef NEWICK_HPP
+#define NEWICK_HPP
+
 #include "../base/core.hpp"
 
 const std::string startDelimiters = "(,";
@@ -9,4 +12,6 @@ void removeParentLabels(std::string &newick);
 void removeBranchAnnotations(std::string &newick);
 std::string toStringNewick(Converter converter);
 Converter toIntNewick(std::string_view strNewick);
-int getNumLeaves(std::string_view newick);
\ No newline at end of file
+int getNumLeaves(std::string_view newick);
+
+#endif  // NEWICK_HPP
@@ -0,0 +1,168 @@
+#include "tree_index.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#include "../base/to_newick.hpp"
+#include "../utils/parallel.hpp"
+
+TreeIndex::TreeIndex(const PhyloVec &v) : numLeaves(v.size() + 1) {
+    const size_t numNodes = 2 * numLeaves - 1;
+
+    // Children of internal nodes (as in buildNewick)
+    Pairs children;
+    root = getChildren(getPairs(v), numLeaves, children);
+
+    // Pre-order traversal
+    parent.assign(numNodes, root);
+    depth.assign(numNodes, 0);
+    order.reserve(numNodes);
+    rank.resize(numNodes);
+
+    std::vector<unsigned int> stack = {root};
+    while (!stack.empty()) {
+        unsigned int node = stack.back();
+        stack.pop_back();
+
+        rank[node] = order.size();
+        order.push_back(node);
+
+        if (node >= numLeaves) {
+            for (unsigned int child : children[node - numLeaves]) {
+                parent[child] = node;
+                depth[child] = depth[node] + 1;
+                stack.push_back(child);
+            }
+        }
+    }
+
+    // Leaf ranges: a node is followed in pre-order by the rest of its subtree
+    leafOrder.reserve(numLeaves);
+    leafBegin.resize(numNodes);
+    leafEnd.resize(numNodes);
+    for (unsigned int node : order) {
+        leafBegin[node] = leafOrder.size();
+        if (node < numLeaves) {
+            leafOrder.push_back(node);
+        }
+    }
+    for (unsigned int node = 0; node < numLeaves; ++node) {
+        leafEnd[node] = leafBegin[node] + 1;
+    }
+    for (size_t i = numNodes; i-- > 1;) {
+        unsigned int node = order[i];
+        leafEnd[parent[node]] = std::max(leafEnd[parent[node]], leafEnd[node]);
+    }
+
+    // Sparse table
+    floorLog2.resize(numNodes + 1);
+    for (size_t i = 2; i <= numNodes; ++i) {
+        floorLog2[i] = floorLog2[i / 2] + 1;
+    }
+    const unsigned int numLevels = floorLog2[numNodes] + 1;
+    table.resize(numLevels * numNodes);
+
+    for (size_t i = 0; i < numNodes; ++i) {
+        table[i] = rank[parent[order[i]]];
+    }
+    for (unsigned int k = 1; k < numLevels; ++k) {
+        const unsigned int *prev = table.data() + (k - 1) * numNodes;
+        unsigned int *curr = table.data() + k * numNodes;
+        const size_t half = size_t(1) << (k - 1);
+        for (size_t i = 0; i + 2 * half <= numNodes; ++i) {
+            curr[i] = std::min(prev[i], prev[i + half]);
+        }
+    }
+}
+
+void TreeIndex::checkNode(unsigned int node) const {
+    if (node >= parent.size()) {
+        std::ostringstream oss;
+        oss << "Node " << node << " is out of range (number of nodes: " << parent.size() << ")";
+        throw std::out_of_range(oss.str());
+    }
+}
+
+unsigned int TreeIndex::lca(unsigned int node1, unsigned int node2) const {
+    checkNode(node1);
+    checkNode(node2);
+
+    if (node1 == node2) {
+        return node1;
+    }
+
+    unsigned int l = rank[node1];
+    unsigned int r = rank[node2];
+    if (l > r) {
+        std::swap(l, r);
+    }
+
+    // The nodes ranked in (l, r] all descend from the common ancestor,
+    // and the highest of them are its children
+    const size_t numNodes = parent.size();
+    const unsigned int k = floorLog2[r - l];
+    const unsigned int *level = table.data() + k * numNodes;
+
+    return order[std::min(level[l + 1], level[r + 1 - (size_t(1) << k)])];
+}
+
+unsigned int TreeIndex::lca(const std::vector<unsigned int> &nodes) const {
+    if (nodes.empty()) {
+        throw std::invalid_argument("Cannot find the common ancestor of an empty set of nodes");
+    }
+
+    unsigned int first = nodes[0], last = nodes[0];
+    for (unsigned int node : nodes) {
+        checkNode(node);
+        if (rank[node] < rank[first]) {
+            first = node;
+        } else if (rank[node] > rank[last]) {
+            last = node;
+        }
+    }
+
+    return lca(first, last);
+}
+
+std::pair<unsigned int, unsigned int> TreeIndex::getLeafRange(unsigned int node) const {
+    checkNode(node);
+    return {leafBegin[node], leafEnd[node]};
+}
+
+unsigned int TreeIndex::distance(unsigned int node1, unsigned int node2, bool unrooted) const {
+    unsigned int ancestor = lca(node1, node2);
+
+    unsigned int dist = depth[node1] + depth[node2] - 2 * depth[ancestor];
+
+    // Crossing the root of an unrooted tree
+    if (unrooted && ancestor == root && node1 != root && node2 != root && node1 != node2) {
+        dist -= 1;
+    }
+
+    return dist;
+}
+
+std::vector<unsigned int> TreeIndex::lcaBatch(const Pairs &pairs, unsigned int numThreads) const {
+    std::vector<unsigned int> ancestors(pairs.size());
+
+    parallelFor(
+        pairs.size(), numThreads,
+        [&](size_t i, unsigned int) { ancestors[i] = lca(pairs[i][0], pairs[i][1]); }, 4096);
+
+    return ancestors;
+}
+
+std::vector<unsigned int> TreeIndex::distanceBatch(const Pairs &pairs, bool unrooted,
+                                                   unsigned int numThreads) const {
+    std::vector<unsigned int> distances(pairs.size());
+
+    parallelFor(
+        pairs.size(), numThreads,
+        [&](size_t i, unsigned int) {
+            distances[i] = distance(pairs[i][0], pairs[i][1], unrooted);
+        },
+        4096);
+
+    return distances;
+}
@@ -0,0 +1,126 @@
+#ifndef TREE_INDEX_HPP
+#define TREE_INDEX_HPP
+
+/**
+ * @file tree_index.hpp
+ * @brief Constant-time common ancestor and distance queries on a fixed tree
+ */
+
+#include <utility>
+#include <vector>
+
+#include "../base/core.hpp"
+
+/**
+ * @brief Index of the nodes of a tree built once from a Phylo2Vec vector
+ * Leaves are 0, ..., n - 1 and the parent of the i-th cherry of getAncestry(v) is n + i.
+ * Building takes O(n log n) time and memory: nodes are numbered in pre-order,
+ * and a sparse table stores the range minimum of the pre-order rank of their parents.
+ * The common ancestor of two nodes is the minimum over the ranks between them.
+ * The leaves below a node are contiguous in pre-order, so they are stored once as ranges.
+ * Queries are O(1) and the index is read-only, so it can be shared between threads.
+ */
+class TreeIndex {
+   public:
+    explicit TreeIndex(const PhyloVec &v);
+
+    size_t getNumLeaves() const { return numLeaves; }
+    size_t getNumNodes() const { return parent.size(); }
+    unsigned int getRoot() const { return root; }
+    unsigned int getParent(unsigned int node) const { return parent[node]; }
+    unsigned int getDepth(unsigned int node) const { return depth[node]; }
+
+    /**
+     * @brief Most recent common ancestor of two nodes
+     * @param node1 first node
+     * @param node2 second node
+     * @return unsigned int common ancestor (node1 if node1 == node2)
+     */
+    unsigned int lca(unsigned int node1, unsigned int node2) const;
+
+    /**
+     * @brief Most recent common ancestor of a set of nodes, in O(k):
+     * that of the first and last of them in pre-order
+     * @param nodes nodes
+     * @return unsigned int common ancestor
+     * @throws std::invalid_argument if nodes is empty
+     */
+    unsigned int lca(const std::vector<unsigned int> &nodes) const;
+
+    /**
+     * @brief Topological distance (number of edges) between two nodes
+     * @param node1 first node
+     * @param node2 second node
+     * @param unrooted if true, the two root edges count as one
+     * (as in copheneticDistances)
+     * @return unsigned int distance
+     */
+    unsigned int distance(unsigned int node1, unsigned int node2, bool unrooted = false) const;
+
+    /**
+     * @brief Common ancestors of many pairs of nodes in parallel
+     * @param pairs pairs of nodes
+     * @param numThreads number of threads (0 = all hardware threads)
+     * @return std::vector<unsigned int> common ancestor of each pair
+     */
+    std::vector<unsigned int> lcaBatch(const Pairs &pairs, unsigned int numThreads = 0) const;
+
+    /**
+     * @brief Topological distances between many pairs of nodes in parallel
+     * @param pairs pairs of nodes
+     * @param unrooted if true, the two root edges count as one
+     * @param numThreads number of threads (0 = all hardware threads)
+     * @return std::vector<unsigned int> distance of each pair
+     */
+    std::vector<unsigned int> distanceBatch(const Pairs &pairs, bool unrooted = false,
+                                            unsigned int numThreads = 0) const;
+
+    /**
+     * @brief Call fn on a node, then on each of its ancestors up to the root
+     * @param node first node of the path
+     * @param fn callable taking a node
+     */
+    template <typename Fn>
+    void forEachAncestor(unsigned int node, Fn fn) const {
+        checkNode(node);
+        fn(node);
+        while (node != root) {
+            node = parent[node];
+            fn(node);
+        }
+    }
+
+    /**
+     * @brief Leaves in pre-order, so that the leaves below each node are contiguous
+     */
+    const std::vector<unsigned int> &getLeafOrder() const { return leafOrder; }
+
+    /**
+     * @brief Range of the leaves below a node in getLeafOrder()
+     * @param node node
+     * @return std::pair<unsigned int, unsigned int> [begin, end) positions
+     */
+    std::pair<unsigned int, unsigned int> getLeafRange(unsigned int node) const;
+
+   private:
+    void checkNode(unsigned int node) const;
+
+    size_t numLeaves;
+    unsigned int root;
+    std::vector<unsigned int> parent;
+    std::vector<unsigned int> depth;
+    // Nodes in pre-order, and pre-order rank of each node
+    std::vector<unsigned int> order;
+    std::vector<unsigned int> rank;
+    // Leaves in pre-order, and range of the leaves below each node
+    std::vector<unsigned int> leafOrder;
+    std::vector<unsigned int> leafBegin;
+    std::vector<unsigned int> leafEnd;
+    // Level k of the sparse table starts at k * numNodes:
+    // table[k * numNodes + i] = min(rank[parent[order[j]]] for j in [i, i + 2^k))
+    std::vector<unsigned int> table;
+    // Floor of log2(i) for i in [1, numNodes]
+    std::vector<unsigned char> floorLog2;
+};
+
+#endif  // TREE_INDEX_HPP
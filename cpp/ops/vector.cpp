@@ -6,25 +6,66 @@
 
 #include "../base/to_newick.hpp"
 #include "../base/to_vector.hpp"
+#include "../utils/parallel.hpp"
+#include "tree_index.hpp"
 
-PhyloVec sample(const size_t &numLeaves, bool ordered) {
-    PhyloVec v(numLeaves - 1);
-    // static std::mt19937 gen(std::random_device{}());
-    static std::minstd_rand gen(std::random_device{}());
+void sample(unsigned int *v, size_t numLeaves, bool ordered, CounterRNG &rng) {
+    // A single leaf has an empty vector (and possibly no buffer)
+    if (numLeaves < 2) {
+        return;
+    }
+
+    v[0] = 0;
 
     if (ordered) {
         for (size_t i = 1; i < numLeaves - 1; ++i) {
-            v[i] = gen() % (i + 1);
+            v[i] = rng.bounded(i + 1);
         }
     } else {
         for (size_t i = 1; i < numLeaves - 1; ++i) {
-            v[i] = gen() % (2 * i + 1);
+            v[i] = rng.bounded(2 * i + 1);
         }
     }
+}
+
+PhyloVec sample(const size_t &numLeaves, bool ordered) {
+    // One generator per thread, seeded non-deterministically
+    thread_local CounterRNG rng(
+        (static_cast<std::uint64_t>(std::random_device{}()) << 32) | std::random_device{}());
+
+    PhyloVec v(numLeaves - 1);
+    sample(v.data(), numLeaves, ordered, rng);
 
     return v;
 }
 
+PhyloVec sample(const size_t &numLeaves, bool ordered, std::uint64_t seed, std::uint64_t stream) {
+    CounterRNG rng(seed, stream);
+
+    PhyloVec v(numLeaves - 1);
+    sample(v.data(), numLeaves, ordered, rng);
+
+    return v;
+}
+
+std::vector<unsigned int> sampleMany(size_t count, size_t numLeaves, std::uint64_t seed,
+                                     bool ordered, unsigned int numThreads) {
+    const size_t k = numLeaves - 1;
+
+    std::vector<unsigned int> vs(count * k);
+
+    // Tree i is drawn from stream i: the output does not depend on the number of threads
+    parallelFor(
+        count, numThreads,
+        [&](size_t i, unsigned int) {
+            CounterRNG rng(seed, i);
+            sample(vs.data() + i * k, numLeaves, ordered, rng);
+        },
+        64);
+
+    return vs;
+}
+
 void check_v(const PhyloVec &v) {
     // check that v is valid: 0 <= v[i] <= 2i
 
@@ -39,6 +80,227 @@ void check_v(const PhyloVec &v) {
     }
 }
 
+// Vector of a tree given by the children of its internal nodes,
+// where leaf i is relabelled leafLabels[i]
+static void buildVector(const Pairs &children, unsigned int root,
+                        const std::vector<unsigned int> &leafLabels, PhyloVec &v) {
+    const unsigned int numLeaves = leafLabels.size();
+    const unsigned int numCherries = numLeaves - 1;
+
+    // Internal nodes in pre-order: labelled numLeaves, ... in reverse,
+    // so that parents follow their children
+    std::vector<unsigned int> preOrder;
+    preOrder.reserve(numCherries);
+    std::vector<unsigned int> stack = {root};
+    while (!stack.empty()) {
+        unsigned int node = stack.back();
+        stack.pop_back();
+        if (node >= numLeaves) {
+            preOrder.push_back(node);
+            stack.push_back(children[node - numLeaves][0]);
+            stack.push_back(children[node - numLeaves][1]);
+        }
+    }
+
+    std::vector<unsigned int> labels(leafLabels);
+    labels.resize(2 * numLeaves - 1);
+    for (unsigned int i = 0; i < numCherries; ++i) {
+        labels[preOrder[numCherries - 1 - i]] = numLeaves + i;
+    }
+
+    Ancestry ancestry(numCherries);
+    for (unsigned int i = 0; i < numCherries; ++i) {
+        auto &[c1, c2] = children[preOrder[numCherries - 1 - i] - numLeaves];
+        ancestry[i] = {int(labels[c1]), int(labels[c2]), int(numLeaves + i)};
+    }
+
+    orderCherries(ancestry);
+    orderCherriesNoParents(ancestry);
+    v = buildVector(ancestry);
+}
+
+// Relabel leaf i as leafLabels[i] in a tree and its taxon mapping
+template <typename Mapping>
+static void relabelLeaves(PhyloVec &v, Mapping &mapping, const Pairs &children,
+                          unsigned int root, const std::vector<unsigned int> &leafLabels) {
+    if (!mapping.empty()) {
+        Mapping relabelled(mapping.size());
+        for (size_t i = 0; i < mapping.size(); ++i) {
+            relabelled[leafLabels[i]] = mapping[i];
+        }
+        mapping.swap(relabelled);
+    }
+
+    buildVector(children, root, leafLabels, v);
+}
+
+template <typename Mapping>
+static void checkMapping(const PhyloVec &v, const Mapping &mapping) {
+    if (!mapping.empty() && mapping.size() != v.size() + 1) {
+        std::ostringstream oss;
+        oss << "Mapping has " << mapping.size() << " taxa, expected " << v.size() + 1;
+        throw std::invalid_argument(oss.str());
+    }
+}
+
+template <typename Mapping>
+static void relabelBirthDeath(PhyloVec &v, Mapping &mapping, CounterRNG *rng) {
+    checkMapping(v, mapping);
+    // A single leaf keeps its label
+    if (v.empty()) {
+        return;
+    }
+
+    const unsigned int numLeaves = v.size() + 1;
+    Pairs children;
+    const unsigned int root = getChildren(getPairs(v), numLeaves, children);
+
+    // Smallest new label of the leaves below each node
+    std::vector<unsigned int> code(2 * numLeaves - 1);
+    code[root] = 0;
+
+    // Breadth-first traversal of the internal nodes
+    std::vector<unsigned int> queue = {root};
+    queue.reserve(numLeaves - 1);
+    for (size_t k = 0; k < queue.size(); ++k) {
+        const unsigned int node = queue[k];
+        auto [c1, c2] = children[node - numLeaves];
+        code[c1] = code[node];
+        code[c2] = k + 1;
+
+        // Shuffling changes the order in which the subtrees are visited
+        if (rng && rng->bounded(2)) {
+            std::swap(c1, c2);
+        }
+        for (unsigned int child : {c1, c2}) {
+            if (child >= numLeaves) {
+                queue.push_back(child);
+            }
+        }
+    }
+
+    code.resize(numLeaves);
+    relabelLeaves(v, mapping, children, root, code);
+}
+
+void reorderBirthDeath(PhyloVec &v, Leaf2Taxon &mapping) {
+    relabelBirthDeath(v, mapping, nullptr);
+}
+
+void reorderBirthDeath(PhyloVec &v, Leaf2Taxon &mapping, CounterRNG &rng) {
+    relabelBirthDeath(v, mapping, &rng);
+}
+
+template <typename Mapping>
+static void relabelBFS(PhyloVec &v, Mapping &mapping) {
+    checkMapping(v, mapping);
+    // A single leaf keeps its label
+    if (v.empty()) {
+        return;
+    }
+
+    const unsigned int numLeaves = v.size() + 1;
+    Pairs children;
+    const unsigned int root = getChildren(getPairs(v), numLeaves, children);
+
+    // Leaves are labelled in the order they are reached
+    std::vector<unsigned int> leafLabels(numLeaves);
+    unsigned int label = 0;
+    std::vector<unsigned int> queue = {root};
+    queue.reserve(numLeaves - 1);
+    for (size_t k = 0; k < queue.size(); ++k) {
+        for (unsigned int child : children[queue[k] - numLeaves]) {
+            if (child < numLeaves) {
+                leafLabels[child] = label++;
+            } else {
+                queue.push_back(child);
+            }
+        }
+    }
+
+    relabelLeaves(v, mapping, children, root, leafLabels);
+}
+
+void reorderBFS(PhyloVec &v, Leaf2Taxon &mapping) {
+    relabelBFS(v, mapping);
+}
+
+template <typename Mapping>
+static void relabel(PhyloVec &v, Mapping &mapping, std::string_view method) {
+    if (method == "birth_death") {
+        relabelBirthDeath(v, mapping, nullptr);
+    } else if (method == "bfs") {
+        relabelBFS(v, mapping);
+    } else {
+        throw std::invalid_argument("`method` must be 'birth_death' or 'bfs'");
+    }
+}
+
+void reorder(PhyloVec &v, Leaf2Taxon &mapping, std::string_view method) {
+    relabel(v, mapping, method);
+}
+
+void reorder(PhyloVec &v, std::vector<unsigned int> &taxa, std::string_view method) {
+    relabel(v, taxa, method);
+}
+
+void rerootAtRandom(PhyloVec &v, CounterRNG &rng) {
+    // A single leaf has no edge to reroot on
+    if (v.empty()) {
+        return;
+    }
+    const unsigned int numLeaves = v.size() + 1;
+    const unsigned int numNodes = 2 * numLeaves - 1;
+    Pairs children;
+    const unsigned int root = getChildren(getPairs(v), numLeaves, children);
+
+    std::vector<unsigned int> parent(numNodes, root);
+    for (unsigned int i = 0; i + 1 < numLeaves; ++i) {
+        for (unsigned int child : children[i]) {
+            parent[child] = numLeaves + i;
+        }
+    }
+
+    // Non-root node below the new root (the root has the largest label)
+    const unsigned int node = rng.bounded(numNodes - 1);
+    if (parent[node] == root) {
+        return;
+    }
+
+    // Reverse the edges on the path from node to the root:
+    // each ancestor adopts its parent instead of its child on the path,
+    // and the other child of the root replaces the root
+    const unsigned int top = parent[node];
+    unsigned int prev = node;
+    for (unsigned int curr = top; curr != root; prev = curr, curr = parent[curr]) {
+        auto &[c1, c2] = children[curr - numLeaves];
+        const unsigned int sister = c1 == prev ? c2 : c1;
+
+        unsigned int next = parent[curr];
+        if (next == root) {
+            auto &[r1, r2] = children[root - numLeaves];
+            next = r1 == curr ? r2 : r1;
+        }
+
+        children[curr - numLeaves] = {sister, next};
+    }
+    children[root - numLeaves] = {node, top};
+
+    std::vector<unsigned int> leafLabels(numLeaves);
+    for (unsigned int i = 0; i < numLeaves; ++i) {
+        leafLabels[i] = i;
+    }
+    buildVector(children, root, leafLabels, v);
+}
+
+void rerootAtRandom(PhyloVec &v) {
+    // One generator per thread, seeded non-deterministically
+    thread_local CounterRNG rng(
+        (static_cast<std::uint64_t>(std::random_device{}()) << 32) | std::random_device{}());
+
+    rerootAtRandom(v, rng);
+}
+
 std::pair<size_t, size_t> findCoordsOfFirstLeaf(const Ancestry &ancestry, int leaf) {
     std::pair<size_t, size_t> coords;
     for (size_t r = 0; r < ancestry.size(); ++r) {
@@ -70,9 +332,11 @@ void addLeaf(PhyloVec &v, unsigned int leaf, unsigned int pos) {
     ancestryAdd[leafRow][leafCol] = -1;
 
     // Increment the other leaves that are >= leaf
+    // (internal nodes keep their labels, so that they stay below 2 * numLeaves - 1)
+    const int numLeaves = v.size() + 1;
     for (size_t r = 0; r < ancestryAdd.size(); ++r) {
         for (size_t c = 0; c < 3; ++c) {
-            if (ancestryAdd[r][c] >= leaf) {
+            if (ancestryAdd[r][c] >= int(leaf) && ancestryAdd[r][c] < numLeaves) {
                 ancestryAdd[r][c] += 1;
             }
         }
@@ -145,49 +409,21 @@ unsigned int removeLeaf(PhyloVec &v, unsigned int leaf) {
 }
 
 std::vector<std::vector<unsigned int>> getAncestryPaths(const PhyloVec &v) {
-    Ancestry ancestry = getAncestry(v);
-
-    unsigned int root = 2 * v.size();
+    // For queries on the same tree, use TreeIndex::forEachAncestor instead
+    TreeIndex index(v);
 
-    std::vector<unsigned int> parent_vec(root, 0);
+    const unsigned int root = index.getRoot();
 
-    for (size_t i = 0; i < v.size(); ++i) {
-        parent_vec[ancestry[i][0]] = ancestry[i][2];
-        parent_vec[ancestry[i][1]] = ancestry[i][2];
-    }
-
-    std::vector<std::vector<unsigned int>> ancestryPaths;
+    std::vector<std::vector<unsigned int>> ancestryPaths(root);
 
     for (unsigned int j = 0; j < root; ++j) {
-        unsigned int lastNode = j;
-        std::vector<unsigned int> path = {lastNode};
-
-        while (lastNode != root) {
-            lastNode = parent_vec[path[0]];
-            path.push_back(lastNode);
-        }
-
-        ancestryPaths.push_back(path);
+        index.forEachAncestor(j, [&](unsigned int node) { ancestryPaths[j].push_back(node); });
     }
 
     return ancestryPaths;
 }
-int getCommonAncestor(const PhyloVec &v, unsigned int node1, unsigned int node2) {
-    std::vector<std::vector<unsigned int>> ancestry_paths = getAncestryPaths(v);
 
-    std::vector<unsigned int> path1 = ancestry_paths[node1];
-    std::vector<unsigned int> path2 = ancestry_paths[node2];
-
-    unsigned int i = 0, j = 0;
-    while (i < path1.size() && j < path2.size()) {
-        if (path1[i] == path2[j]) {
-            return path1[i];  // Found MRCA
-        } else if (path1[i] < path2[j]) {
-            i++;  // Move pointer in vec1 forward
-        } else {
-            j++;  // Move pointer in vec2 forward
-        }
-    }
-
-    return 2 * v.size();  // No common element found --> return root
+int getCommonAncestor(const PhyloVec &v, unsigned int node1, unsigned int node2) {
+    // For many queries on the same tree, build a TreeIndex once instead
+    return TreeIndex(v).lca(node1, node2);
 }
\ No newline at end of file
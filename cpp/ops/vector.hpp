@@ -1,13 +1,106 @@
+#ifndef OPS_VECTOR_HPP
+#define OPS_VECTOR_HPP
+
+#include <cstdint>
+#include <string_view>
+
 #include "../base/core.hpp"
+#include "../utils/random.hpp"
 
 PhyloVec sample(const size_t &numLeaves, bool ordered = false);
+
+/**
+ * @brief Sample a random Phylo2Vec vector reproducibly
+ * @param numLeaves number of leaves
+ * @param ordered if true, sample an ordered vector (v[i] <= i)
+ * @param seed random seed
+ * @param stream stream id: each (seed, stream) pair yields an independent sequence
+ * @return PhyloVec
+ */
+PhyloVec sample(const size_t &numLeaves, bool ordered, std::uint64_t seed,
+                std::uint64_t stream = 0);
+
+/**
+ * @brief Sample a Phylo2Vec vector into a buffer of numLeaves - 1 entries
+ * @param v output buffer
+ * @param numLeaves number of leaves
+ * @param ordered if true, sample an ordered vector (v[i] <= i)
+ * @param rng random generator
+ */
+void sample(unsigned int *v, size_t numLeaves, bool ordered, CounterRNG &rng);
+
+/**
+ * @brief Sample many Phylo2Vec vectors reproducibly and in parallel
+ * Vector i is drawn from stream i of the seed,
+ * so the output does not depend on the number of threads.
+ * @param count number of vectors
+ * @param numLeaves number of leaves
+ * @param seed random seed
+ * @param ordered if true, sample ordered vectors (v[i] <= i)
+ * @param numThreads number of threads (0 = all hardware threads)
+ * @return std::vector<unsigned int> contiguous buffer of shape (count, numLeaves - 1)
+ */
+std::vector<unsigned int> sampleMany(size_t count, size_t numLeaves, std::uint64_t seed,
+                                     bool ordered = false, unsigned int numThreads = 0);
 void check_v(const PhyloVec &v);
+
+/**
+ * @brief Relabel the leaves of a tree, in place, without changing its topology
+ * @param v Phylo2Vec vector
+ * @param mapping taxon of each leaf, permuted as the leaves (or empty)
+ * @param method "birth_death" (see reorderBirthDeath) or "bfs" (see reorderBFS)
+ * @throws std::invalid_argument if method is unknown or mapping has the wrong size
+ */
 void reorder(PhyloVec &v, Leaf2Taxon &mapping, std::string_view method);
-void reorderBirthDeath(Ancestry &abort, Leaf2Taxon &mapping, bool reorderInternal = true,
-                       bool shuffleCols = true);
+
+/**
+ * @brief reorder, permuting the indices of the taxa of the leaves
+ * @param taxa index of the taxon of each leaf (e.g., a row of a distance matrix), or empty
+ */
+void reorder(PhyloVec &v, std::vector<unsigned int> &taxa, std::string_view method);
+
+/**
+ * @brief Relabel the leaves as in a birth-death process, in place, giving an ordered vector
+ * The tree is visited breadth-first from the root: the k-th internal node visited (from 0)
+ * keeps the smallest label of its leaves for its first child and gives label k + 1
+ * to the leaves of its second child. Takes O(n log n).
+ * @param v Phylo2Vec vector
+ * @param mapping taxon of each leaf, permuted as the leaves (or empty)
+ * @throws std::invalid_argument if mapping has the wrong size
+ */
+void reorderBirthDeath(PhyloVec &v, Leaf2Taxon &mapping);
+
+/**
+ * @brief reorderBirthDeath, visiting the two children of each node in a random order
+ * @param rng random generator
+ */
+void reorderBirthDeath(PhyloVec &v, Leaf2Taxon &mapping, CounterRNG &rng);
+
+/**
+ * @brief Relabel the leaves in the order of a breadth-first traversal from the root, in place
+ * @param v Phylo2Vec vector
+ * @param mapping taxon of each leaf, permuted as the leaves (or empty)
+ * @throws std::invalid_argument if mapping has the wrong size
+ */
+void reorderBFS(PhyloVec &v, Leaf2Taxon &mapping);
+
+/**
+ * @brief Reroot a tree on the branch above a uniformly random non-root node, in place
+ * Leaf labels are unchanged. Takes O(n log n).
+ * @param v Phylo2Vec vector
+ * @param rng random generator
+ */
+void rerootAtRandom(PhyloVec &v, CounterRNG &rng);
+
+/**
+ * @brief rerootAtRandom with a non-deterministically seeded generator
+ */
 void rerootAtRandom(PhyloVec &v);
+
 unsigned int removeLeaf(PhyloVec &v, unsigned int leaf);
 void addLeaf(PhyloVec &v, unsigned int leaf, unsigned int pos);
 std::pair<size_t, size_t> findCoordsOfFirstLeaf(const Ancestry &ancestry, int leaf);
 std::vector<std::vector<unsigned int>> getAncestryPaths(const PhyloVec &v);
-int getCommonAncestor(const PhyloVec &v, unsigned int node1, unsigned int node2);
\ No newline at end of file
+int getCommonAncestor(const PhyloVec &v, unsigned int node1, unsigned int node2);
+
+#endif  // OPS_VECTOR_HPP
@@ -0,0 +1,99 @@
+#include "hill_climbing.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include "../base/to_newick.hpp"
+#include "../ops/neighbourhood.hpp"
+#include "../ops/vector.hpp"
+#include "../utils/parallel.hpp"
+#include "../utils/random.hpp"
+
+// Number of ranges of proposals of an entry per thread, to balance uneven loss evaluations
+static constexpr size_t RANGES_PER_THREAD = 4;
+
+HillClimbingResult hillClimbing(const PhyloVec &v, const TreeLoss &loss,
+                                const HillClimbingOptions &options,
+                                const HillClimbingProgressCallback &progress) {
+    if (v.empty()) {
+        throw std::invalid_argument("Trees must have at least two leaves");
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    // Proposals of each entry are shared out in a few ranges per thread, taken dynamically:
+    // each range pays one Neighbourhood setup (O(n log n)), then only changed pairs are updated
+    ThreadPool pool(options.numThreads);
+    const size_t maxRanges = pool.size() == 1 ? 1 : RANGES_PER_THREAD * pool.size();
+    std::vector<Neighbourhood> neighbourhoods(pool.size());
+
+    HillClimbingResult result;
+    result.v = v;
+    result.taxa.resize(v.size() + 1);
+    std::iota(result.taxa.begin(), result.taxa.end(), 0);
+
+    PhyloVec &best = result.v;
+    double currentLoss = loss(getPairs(best), result.taxa);
+    result.losses = {currentLoss};
+    result.numEvaluations = 1;
+
+    CounterRNG rng(options.seed);
+
+    // Loss of each proposal of an entry
+    std::vector<double> proposalLosses;
+
+    unsigned int wait = 0;
+    for (size_t pass = 0; wait < options.patience; ++pass) {
+        rerootAtRandom(best, rng);
+        reorder(best, result.taxa, options.reorderMethod);
+
+        double passLoss = loss(getPairs(best), result.taxa);
+        ++result.numEvaluations;
+
+        for (size_t round = 0; round < options.rounds; ++round) {
+            for (size_t i = best.size(); i-- > 1;) {
+                const unsigned int current = best[i];
+
+                const size_t numProposals = 2 * i + 1;
+                const size_t numRanges = std::min(maxRanges, numProposals);
+                proposalLosses.resize(numProposals);
+                pool.parallelFor(numRanges, [&](size_t r, unsigned int thread) {
+                    neighbourhoods[thread].forEach(
+                        best, i, r * numProposals / numRanges, (r + 1) * numProposals / numRanges,
+                        [&](unsigned int j, const Pairs &pairs) {
+                            proposalLosses[j] = j == current
+                                                    ? std::numeric_limits<double>::infinity()
+                                                    : loss(pairs, result.taxa);
+                        });
+                });
+                result.numEvaluations += 2 * i;
+
+                auto choice = std::min_element(proposalLosses.begin(), proposalLosses.end());
+                if (*choice < passLoss) {
+                    best[i] = choice - proposalLosses.begin();
+                    passLoss = *choice;
+                }
+
+                if (progress) {
+                    const std::chrono::duration<double> elapsed =
+                        std::chrono::steady_clock::now() - start;
+                    progress({pass, round, i, passLoss, result.numEvaluations, elapsed.count()});
+                }
+            }
+        }
+
+        // Reset the patience counter only on a significant improvement
+        if (currentLoss - passLoss > options.tol) {
+            wait = 0;
+        } else {
+            ++wait;
+        }
+        currentLoss = passLoss;
+        result.losses.push_back(currentLoss);
+    }
+
+    return result;
+}
@@ -0,0 +1,85 @@
+#ifndef HILL_CLIMBING_HPP
+#define HILL_CLIMBING_HPP
+
+/**
+ * @file hill_climbing.hpp
+ * @brief Hill-climbing optimisation of a tree over its Phylo2Vec vector
+ * (as HillClimbingOptimizer in phylo2vec/opt/_hc.py, with an in-process loss)
+ */
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "../base/core.hpp"
+#include "losses.hpp"
+
+/**
+ * @brief Parameters of the hill-climbing optimisation
+ */
+struct HillClimbingOptions {
+    // Leaf reordering method at the start of each pass (see reorder)
+    std::string reorderMethod = "birth_death";
+    // Minimum decrease of the loss over a pass to reset the patience counter
+    double tol = 0.001;
+    // Number of consecutive passes without improvement before stopping
+    unsigned int patience = 3;
+    // Number of sweeps over the entries of the vector in each pass
+    unsigned int rounds = 1;
+    // Number of threads evaluating proposals (0 = all hardware threads)
+    unsigned int numThreads = 0;
+    // Seed of the random rerooting at the start of each pass
+    std::uint64_t seed = 0;
+};
+
+/**
+ * @brief Progress of the optimisation, reported after each entry of the vector
+ */
+struct HillClimbingProgress {
+    size_t pass;
+    size_t round;
+    size_t index;
+    double loss;
+    size_t numEvaluations;
+    double seconds;
+};
+
+typedef std::function<void(const HillClimbingProgress &)> HillClimbingProgressCallback;
+
+/**
+ * @brief Result of the optimisation
+ */
+struct HillClimbingResult {
+    PhyloVec v;
+    // Index of the taxon of each leaf of v
+    std::vector<unsigned int> taxa;
+    // Loss of the initial tree, then after each pass
+    std::vector<double> losses;
+    size_t numEvaluations;
+};
+
+/**
+ * @brief Minimise a loss by changing one entry of the vector at a time
+ *
+ * Each pass reroots the tree at random and reorders its leaves (the loss should not depend
+ * on the root or the labels), then, for each round, sweeps the entries i from last to second:
+ * the 2i alternative values of v[i] are evaluated in parallel and the best one is kept
+ * if it decreases the loss. The proposals are split into ranges handed out dynamically
+ * to the threads of a pool kept for the whole optimisation; each thread enumerates
+ * the pairs of its range incrementally (see Neighbourhood), so the loss is almost the only
+ * work per proposal.
+ * Passes stop after `patience` consecutive passes that decrease the loss by less than `tol`.
+ *
+ * @param v initial Phylo2Vec vector (leaf i is taxon i)
+ * @param loss loss to minimise, safe to call from several threads at once
+ * @param options parameters of the optimisation
+ * @param progress called from the calling thread after each entry (may be empty)
+ * @return HillClimbingResult best vector, taxa of its leaves and loss history
+ * @throws std::invalid_argument if v has fewer than two leaves or the reorder method is unknown
+ */
+HillClimbingResult hillClimbing(const PhyloVec &v, const TreeLoss &loss,
+                                const HillClimbingOptions &options = HillClimbingOptions(),
+                                const HillClimbingProgressCallback &progress = nullptr);
+
+#endif  // HILL_CLIMBING_HPP
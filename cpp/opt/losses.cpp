@@ -0,0 +1,161 @@
+#include "losses.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+static void checkNumLeaves(size_t numLeaves, size_t numTaxa) {
+    if (numLeaves != numTaxa) {
+        std::ostringstream oss;
+        oss << "Tree has " << numLeaves << " leaves, but the loss has " << numTaxa << " taxa";
+        throw std::invalid_argument(oss.str());
+    }
+}
+
+TreeLoss makeBMELoss(const std::vector<double> &distances, size_t numTaxa) {
+    if (distances.size() != numTaxa * numTaxa) {
+        std::ostringstream oss;
+        oss << "Distance matrix has " << distances.size() << " entries, expected " << numTaxa
+            << " x " << numTaxa;
+        throw std::invalid_argument(oss.str());
+    }
+
+    auto matrix = std::make_shared<std::vector<double>>(distances);
+
+    return [=](const Pairs &pairs, const std::vector<unsigned int> &taxa) {
+        const size_t numLeaves = pairs.size() + 1;
+        checkNumLeaves(numLeaves, numTaxa);
+
+        // Per-thread scratch space
+        thread_local std::vector<unsigned int> next, last, start, size, rows;
+        thread_local std::vector<double> weights;
+
+        // Merging the subtree of c2 after that of c1 keeps the leaves of every subtree
+        // contiguous in the final order: find that order with linked lists
+        next.assign(numLeaves, numLeaves);
+        last.resize(numLeaves);
+        std::iota(last.begin(), last.end(), 0);
+        for (const auto &[c1, c2] : pairs) {
+            next[last[c1]] = c2;
+            last[c1] = last[c2];
+        }
+        start.resize(numLeaves);
+        rows.resize(numLeaves);
+        for (unsigned int leaf = 0, position = 0; leaf < numLeaves; leaf = next[leaf]) {
+            start[leaf] = position;
+            rows[position++] = taxa[leaf];
+        }
+
+        // 2^(-depth) of each leaf (in final order) below the subtree last merged into it
+        weights.assign(numLeaves, 1.0);
+        size.assign(numLeaves, 1);
+
+        double loss = 0;
+        for (size_t p = 0; p < pairs.size(); ++p) {
+            const auto &[c1, c2] = pairs[p];
+            const unsigned int begin1 = start[c1], begin2 = start[c2];
+            const unsigned int end2 = begin2 + size[c2];
+
+            // d(a, b) = depth(a) + depth(b) + 2, minus 1 across the root of the unrooted tree
+            double sum = 0;
+            for (unsigned int a = begin1; a < begin2; ++a) {
+                const double *row = matrix->data() + rows[a] * numTaxa;
+                double rowSum = 0;
+                for (unsigned int b = begin2; b < end2; ++b) {
+                    rowSum += row[rows[b]] * weights[b];
+                }
+                sum += weights[a] * rowSum;
+            }
+            loss += sum * (p + 1 == pairs.size() ? 0.5 : 0.25);
+
+            for (unsigned int a = begin1; a < end2; ++a) {
+                weights[a] *= 0.5;
+            }
+            size[c1] += size[c2];
+        }
+        return loss;
+    };
+}
+
+// Set of nucleotides (bits A, C, G, T) matched by each character
+static std::array<std::uint8_t, 256> getNucleotideSets() {
+    std::array<std::uint8_t, 256> sets;
+    sets.fill(15);
+
+    const std::pair<char, std::uint8_t> codes[] = {
+        {'A', 1},         {'C', 2},         {'G', 4},         {'T', 8},
+        {'U', 8},         {'R', 1 | 4},     {'Y', 2 | 8},     {'S', 2 | 4},
+        {'W', 1 | 8},     {'K', 4 | 8},     {'M', 1 | 2},     {'B', 2 | 4 | 8},
+        {'D', 1 | 4 | 8}, {'H', 1 | 2 | 8}, {'V', 1 | 2 | 4},
+    };
+    for (const auto &[c, set] : codes) {
+        sets[static_cast<unsigned char>(c)] = set;
+        sets[static_cast<unsigned char>(std::tolower(c))] = set;
+    }
+
+    return sets;
+}
+
+TreeLoss makeParsimonyLoss(const std::vector<std::string> &sequences) {
+    if (sequences.empty()) {
+        throw std::invalid_argument("Parsimony needs at least one sequence");
+    }
+
+    const std::array<std::uint8_t, 256> nucleotideSets = getNucleotideSets();
+
+    const size_t numTaxa = sequences.size();
+    const size_t numSites = sequences[0].size();
+    auto states = std::make_shared<std::vector<std::uint8_t>>();
+    states->reserve(numTaxa * numSites);
+    for (size_t i = 0; i < numTaxa; ++i) {
+        if (sequences[i].size() != numSites) {
+            std::ostringstream oss;
+            oss << "Sequence " << i << " has " << sequences[i].size() << " sites, expected "
+                << numSites;
+            throw std::invalid_argument(oss.str());
+        }
+        for (char c : sequences[i]) {
+            states->push_back(nucleotideSets[static_cast<unsigned char>(c)]);
+        }
+    }
+
+    return [=](const Pairs &pairs, const std::vector<unsigned int> &taxa) {
+        const size_t numLeaves = pairs.size() + 1;
+        checkNumLeaves(numLeaves, numTaxa);
+
+        // Local copy: writes to the (byte) sets below could otherwise alias the capture
+        const size_t length = numSites;
+
+        // Per-thread state sets of the subtree last merged into each leaf
+        thread_local std::vector<std::uint8_t> sets;
+
+        sets.resize(numLeaves * length);
+        for (size_t leaf = 0; leaf < numLeaves; ++leaf) {
+            std::copy_n(states->data() + taxa[leaf] * length, length,
+                        sets.data() + leaf * length);
+        }
+
+        // Fitch: keep the intersection of the children's sets if not empty,
+        // otherwise their union at the cost of one substitution
+        // (branch-free over the sites of a pair, so that the loop is vectorized)
+        size_t score = 0;
+        for (const auto &[c1, c2] : pairs) {
+            std::uint8_t *__restrict s1 = sets.data() + c1 * length;
+            const std::uint8_t *__restrict s2 = sets.data() + c2 * length;
+            unsigned int changes = 0;
+            for (size_t s = 0; s < length; ++s) {
+                const std::uint8_t common = s1[s] & s2[s];
+                const std::uint8_t empty = common == 0;
+                changes += empty;
+                s1[s] = common | ((s1[s] | s2[s]) & -empty);
+            }
+            score += changes;
+        }
+        return double(score);
+    };
+}
@@ -0,0 +1,48 @@
+#ifndef LOSSES_HPP
+#define LOSSES_HPP
+
+/**
+ * @file losses.hpp
+ * @brief Tree losses evaluated in-process by the optimizers
+ */
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "../base/core.hpp"
+
+/**
+ * @brief Loss of a tree given by its pairs (see getPairs), to minimise
+ * Optimizers enumerate the pairs of neighbouring trees incrementally (see Neighbourhood),
+ * so the loss does not rebuild them from a vector.
+ * taxa[leaf] is the index of the taxon of each leaf (e.g., a row of a distance matrix),
+ * as leaves are relabelled during the optimisation (see reorder).
+ * It is called from several threads at once, so it must not modify shared state.
+ */
+typedef std::function<double(const Pairs &pairs, const std::vector<unsigned int> &taxa)> TreeLoss;
+
+/**
+ * @brief Balanced minimum evolution loss (Pauplin's tree length):
+ * sum over pairs of taxa i < j of D[i][j] * 2^(-d(i, j)),
+ * where d is the number of edges between the leaves of i and j in the unrooted tree
+ * The pairs are merged in order, summing over the leaves on both sides of each merge.
+ * @param distances row-major numTaxa x numTaxa distance matrix
+ * @param numTaxa number of taxa
+ * @return TreeLoss loss, in O(n^2) per tree
+ * @throws std::invalid_argument if distances does not have numTaxa^2 entries
+ */
+TreeLoss makeBMELoss(const std::vector<double> &distances, size_t numTaxa);
+
+/**
+ * @brief Fitch parsimony score: minimum number of substitutions over the alignment
+ * Nucleotides (A, C, G, T/U) and IUPAC ambiguity codes are read case-insensitively;
+ * any other character (gap, N, ?) matches every nucleotide.
+ * Sites are processed together for each pair of the tree (see getPairs), in O(n * sites).
+ * @param sequences aligned sequence of each taxon
+ * @return TreeLoss loss
+ * @throws std::invalid_argument if there are no sequences or their lengths differ
+ */
+TreeLoss makeParsimonyLoss(const std::vector<std::string> &sequences);
+
+#endif  // LOSSES_HPP
@@ -1,24 +1,438 @@
 // #include <pybind11/numpy.h>
+#include <pybind11/functional.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
 #include "../base/to_newick.hpp"
 #include "../base/to_vector.hpp"
+#include "../io/packed.hpp"
+#include "../io/tree_file.hpp"
+#include "../matrix/to_matrix.hpp"
+#include "../matrix/to_newick.hpp"
+#include "../metrics/kendall_colijn.hpp"
+#include "../metrics/pairwise.hpp"
+#include "../metrics/robinson_foulds.hpp"
+#include "../metrics/shape.hpp"
+#include "../ops/dynamic_tree.hpp"
+#include "../ops/neighbourhood.hpp"
+#include "../ops/tree_index.hpp"
 #include "../ops/vector.hpp"
+#include "../opt/hill_climbing.hpp"
+#include "../opt/losses.hpp"
 
 namespace py = pybind11;
 
+// Loss built in C++, kept opaque so that it is called without going through Python
+struct NativeLoss {
+    TreeLoss fn;
+};
+
 PYBIND11_MODULE(phylo2vec, m) {
     m.doc() = "Phylo2Vec: a vector representation for binary trees";
 
-    m.def("to_newick", &toNewick, "Recover a rooted tree(in Newick format) from a Phylo2Vec v");
+    m.def("to_newick", py::overload_cast<const PhyloVec &, bool>(&toNewick),
+          "Recover a rooted tree(in Newick format) from a Phylo2Vec v");
 
-    m.def("to_vector", &toVector, "Convert a Newick string with parent labels to a vector");
+    m.def("to_vector", py::overload_cast<std::string_view>(&toVector),
+          "Convert a Newick string with parent labels to a vector");
 
-    m.def("to_vector_no_parents", &toVectorNoParents,
+    m.def("to_vector_no_parents", py::overload_cast<std::string_view>(&toVectorNoParents),
           "Convert a Newick string without parent labels to a vector");
 
-    m.def("sample", &sample, "Sample a random Phylo2Vec v for n leaves");
+    m.def(
+        "to_matrix",
+        [](std::string_view newick) {
+            PhyloMat mat = toMatrix(newick);
+            return std::make_pair(mat.v, mat.branches);
+        },
+        "Convert a Newick string with parent labels and branch lengths to a matrix "
+        "(returned as a tuple of the vector and the branch lengths)");
+
+    m.def(
+        "to_matrix_no_parents",
+        [](std::string_view newick) {
+            PhyloMat mat = toMatrixNoParents(newick);
+            return std::make_pair(mat.v, mat.branches);
+        },
+        "Convert a Newick string with branch lengths but without parent labels to a matrix "
+        "(returned as a tuple of the vector and the branch lengths)");
+
+    m.def(
+        "to_newick_with_branches",
+        [](const PhyloVec &v, const std::vector<std::array<float, 2>> &branches, int precision) {
+            return toNewick(PhyloMat{v, branches}, precision);
+        },
+        py::arg("v"), py::arg("branches"), py::arg("precision") = SHORTEST_PRECISION,
+        "Recover a rooted tree with branch lengths (in Newick format) from a matrix. "
+        "Branch lengths use the shortest round-trip format unless a precision is given");
+
+    m.def("to_newick_batch", &toNewickBatch, py::arg("vs"), py::arg("with_internals") = true,
+          py::arg("n_threads") = 0, py::call_guard<py::gil_scoped_release>(),
+          "Recover many rooted trees (in Newick format) from Phylo2Vec vectors in parallel");
+
+    m.def("to_vector_batch", &toVectorBatch, py::arg("newicks"), py::arg("n_threads") = 0,
+          py::call_guard<py::gil_scoped_release>(),
+          "Convert many Newick strings with parent labels to vectors in parallel");
+
+    m.def("to_vector_no_parents_batch", &toVectorNoParentsBatch, py::arg("newicks"),
+          py::arg("n_threads") = 0, py::call_guard<py::gil_scoped_release>(),
+          "Convert many Newick strings without parent labels to vectors in parallel");
+
+    py::enum_<NewickLabels>(m, "NewickLabels")
+        .value("PARENTS", NewickLabels::Parents)
+        .value("NO_PARENTS", NewickLabels::NoParents)
+        .value("TAXA", NewickLabels::Taxa);
+
+    m.def(
+        "read_tree_file",
+        [](const std::string &path, NewickLabels labels, unsigned int numThreads) -> py::object {
+            MappedFile file(path);
+            VectorCollection collection;
+            {
+                py::gil_scoped_release release;
+                collection = readTreeFile(file, labels, numThreads);
+            }
+
+            std::vector<PhyloVec> vs(collection.offsets.size() - 1);
+            for (size_t i = 0; i < vs.size(); ++i) {
+                vs[i].assign(collection.data.begin() + collection.offsets[i],
+                             collection.data.begin() + collection.offsets[i + 1]);
+            }
+
+            if (labels != NewickLabels::Taxa) {
+                return py::cast(vs);
+            }
+            // Taxa are copied to Python strings while the file is still mapped
+            return py::make_tuple(vs, collection.taxa);
+        },
+        py::arg("path"), py::arg("labels") = NewickLabels::Parents, py::arg("n_threads") = 0,
+        "Convert all trees of a file (one Newick per line) to vectors in parallel. "
+        "With NewickLabels.TAXA, also return the taxon of each leaf of each tree");
+
+    m.def("write_packed_vectors", &writePackedVectors, py::arg("path"), py::arg("vs"),
+          py::arg("n_threads") = 0, py::call_guard<py::gil_scoped_release>(),
+          "Write vectors with the same number of leaves to a bit-packed binary file");
+
+    py::class_<PackedVectorFile>(m, "PackedVectorFile")
+        .def(py::init<const std::string &>(), py::arg("path"))
+        .def("__len__", &PackedVectorFile::size)
+        .def("__getitem__", py::overload_cast<size_t>(&PackedVectorFile::get, py::const_),
+             py::arg("i"))
+        .def_property_readonly("n_leaves", &PackedVectorFile::getNumLeaves)
+        .doc() = "Memory-mapped bit-packed vector file, decoding vectors on demand";
+
+    py::enum_<DistanceLayout>(m, "DistanceLayout")
+        .value("SQUARE", DistanceLayout::Square)
+        .value("CONDENSED", DistanceLayout::Condensed);
+
+    m.def("cophenetic_distances", &copheneticDistancesFlat, py::arg("v"),
+          py::arg("layout") = DistanceLayout::Square, py::arg("unrooted") = false,
+          py::arg("n_threads") = 0, py::call_guard<py::gil_scoped_release>(),
+          "Topological distances between all leaves as a flat matrix "
+          "(row-major n x n, or condensed upper triangle as scipy's pdist)");
+
+    py::class_<DistanceProgress>(m, "DistanceProgress")
+        .def_readonly("rows_done", &DistanceProgress::rowsDone)
+        .def_readonly("n_rows", &DistanceProgress::numRows)
+        .def_readonly("bytes_written", &DistanceProgress::bytesWritten)
+        .def_readonly("seconds", &DistanceProgress::seconds)
+        .def_readonly("bytes_per_second", &DistanceProgress::bytesPerSecond);
+
+    m.def("write_cophenetic_distances", &writeCopheneticDistances, py::arg("path"), py::arg("v"),
+          py::arg("layout") = DistanceLayout::Condensed, py::arg("unrooted") = false,
+          py::arg("n_threads") = 0, py::arg("progress") = nullptr,
+          py::arg("chunk_bytes") = DEFAULT_DISTANCE_CHUNK_BYTES,
+          py::call_guard<py::gil_scoped_release>(),
+          "Write topological distances between all leaves to a memory-mapped float32 file "
+          "(32-byte header, then the matrix), chunk by chunk, "
+          "calling progress(DistanceProgress) after each chunk");
+
+    m.def(
+        "patristic_distances",
+        [](const PhyloVec &v, const std::vector<std::array<float, 2>> &branches,
+           DistanceLayout layout, unsigned int numThreads) {
+            return patristicDistancesFlat(PhyloMat{v, branches}, layout, numThreads);
+        },
+        py::arg("v"), py::arg("branches"), py::arg("layout") = DistanceLayout::Square,
+        py::arg("n_threads") = 0, py::call_guard<py::gil_scoped_release>(),
+        "Sums of branch lengths between all leaves of a matrix as a flat matrix");
+
+    m.def(
+        "write_patristic_distances",
+        [](const std::string &path, const PhyloVec &v,
+           const std::vector<std::array<float, 2>> &branches, DistanceLayout layout,
+           unsigned int numThreads, const DistanceProgressCallback &progress, size_t chunkBytes) {
+            writePatristicDistances(path, PhyloMat{v, branches}, layout, numThreads, progress,
+                                    chunkBytes);
+        },
+        py::arg("path"), py::arg("v"), py::arg("branches"),
+        py::arg("layout") = DistanceLayout::Condensed, py::arg("n_threads") = 0,
+        py::arg("progress") = nullptr, py::arg("chunk_bytes") = DEFAULT_DISTANCE_CHUNK_BYTES,
+        py::call_guard<py::gil_scoped_release>(),
+        "Write sums of branch lengths between all leaves of a matrix to a memory-mapped float32 "
+        "file (as write_cophenetic_distances)");
+
+    m.def("robinson_foulds", &robinsonFoulds, py::arg("v1"), py::arg("v2"),
+          py::arg("unrooted") = false,
+          "Robinson-Foulds distance between two trees with the same number of leaves");
+
+    m.def("robinson_foulds_all_pairs", &robinsonFouldsAllPairs, py::arg("vs"),
+          py::arg("unrooted") = false, py::arg("n_threads") = 0,
+          py::call_guard<py::gil_scoped_release>(),
+          "Robinson-Foulds distances between all pairs of K trees "
+          "(flattened, shape (K, K))");
+
+    m.def("kendall_colijn_vector",
+          py::overload_cast<const PhyloVec &, unsigned int>(&kendallColijnVector), py::arg("v"),
+          py::arg("n_threads") = 0, py::call_guard<py::gil_scoped_release>(),
+          "Topological Kendall-Colijn vector (common ancestor depths of the leaf pairs "
+          "in condensed order, then pendant edge lengths)");
+
+    m.def(
+        "kendall_colijn_vector",
+        [](const PhyloVec &v, const std::vector<std::array<float, 2>> &branches, double lambda,
+           unsigned int numThreads) {
+            return kendallColijnVector(PhyloMat{v, branches}, lambda, numThreads);
+        },
+        py::arg("v"), py::arg("branches"), py::arg("lam"), py::arg("n_threads") = 0,
+        py::call_guard<py::gil_scoped_release>(),
+        "Kendall-Colijn vector of a matrix: (1 - lam) * topological + lam * branch lengths");
+
+    m.def("kendall_colijn", py::overload_cast<const PhyloVec &, const PhyloVec &>(&kendallColijn),
+          py::arg("v1"), py::arg("v2"),
+          "Topological Kendall-Colijn distance between two trees with the same number of leaves");
+
+    m.def("kendall_colijn_all_pairs",
+          py::overload_cast<const std::vector<PhyloVec> &, unsigned int>(&kendallColijnAllPairs),
+          py::arg("vs"), py::arg("n_threads") = 0, py::call_guard<py::gil_scoped_release>(),
+          "Topological Kendall-Colijn distances between all pairs of K trees "
+          "(flattened, shape (K, K))");
+
+    m.def(
+        "kendall_colijn_all_pairs",
+        [](const std::vector<PhyloVec> &vs,
+           const std::vector<std::vector<std::array<float, 2>>> &branches, double lambda,
+           unsigned int numThreads) {
+            if (vs.size() != branches.size()) {
+                throw std::invalid_argument("vs and branches must have the same length");
+            }
+            std::vector<PhyloMat> ms;
+            ms.reserve(vs.size());
+            for (size_t i = 0; i < vs.size(); ++i) {
+                ms.push_back(PhyloMat{vs[i], branches[i]});
+            }
+            return kendallColijnAllPairs(ms, lambda, numThreads);
+        },
+        py::arg("vs"), py::arg("branches"), py::arg("lam"), py::arg("n_threads") = 0,
+        py::call_guard<py::gil_scoped_release>(),
+        "Kendall-Colijn distances between all pairs of K matrices (flattened, shape (K, K))");
+
+    py::class_<ShapeStats>(m, "ShapeStats")
+        .def_readonly("sackin", &ShapeStats::sackin)
+        .def_readonly("colless", &ShapeStats::colless)
+        .def_readonly("n_cherries", &ShapeStats::numCherries)
+        .def_readonly("height", &ShapeStats::height);
+
+    m.def("shape_stats", &getShapeStats, py::arg("v"),
+          "Sackin and Colless indices, number of cherries and height of a tree");
+
+    m.def("leaf_depth_counts", &getLeafDepthCounts, py::arg("v"),
+          "Number of leaves at each depth of a tree");
+
+    py::class_<ShapeStatsBatch>(m, "ShapeStatsBatch")
+        .def_readonly("sackin", &ShapeStatsBatch::sackin)
+        .def_readonly("colless", &ShapeStatsBatch::colless)
+        .def_readonly("n_cherries", &ShapeStatsBatch::numCherries)
+        .def_readonly("height", &ShapeStatsBatch::height)
+        .def_readonly("depth_offsets", &ShapeStatsBatch::depthOffsets)
+        .def_readonly("depth_counts", &ShapeStatsBatch::depthCounts)
+        .def("__len__", &ShapeStatsBatch::size);
+
+    m.def("shape_stats_batch",
+          py::overload_cast<const std::vector<PhyloVec> &, bool, unsigned int>(
+              &getShapeStatsBatch),
+          py::arg("vs"), py::arg("with_depth_counts") = false, py::arg("n_threads") = 0,
+          py::call_guard<py::gil_scoped_release>(),
+          "Shape statistics of many trees in parallel, as one list per statistic");
+
+    py::class_<TreeIndex>(m, "TreeIndex")
+        .def(py::init<const PhyloVec &>(), py::arg("v"))
+        .def_property_readonly("n_leaves", &TreeIndex::getNumLeaves)
+        .def_property_readonly("root", &TreeIndex::getRoot)
+        .def("lca", py::overload_cast<unsigned int, unsigned int>(&TreeIndex::lca, py::const_),
+             py::arg("node1"), py::arg("node2"))
+        .def("lca",
+             py::overload_cast<const std::vector<unsigned int> &>(&TreeIndex::lca, py::const_),
+             py::arg("nodes"), "Most recent common ancestor of a set of nodes")
+        .def(
+            "path_to_root",
+            [](const TreeIndex &index, unsigned int node) {
+                std::vector<unsigned int> path;
+                index.forEachAncestor(node, [&](unsigned int a) { path.push_back(a); });
+                return path;
+            },
+            py::arg("node"))
+        .def_property_readonly("leaf_order", &TreeIndex::getLeafOrder)
+        .def("leaf_range", &TreeIndex::getLeafRange, py::arg("node"),
+             "Range [begin, end) of the leaves below a node in leaf_order")
+        .def("distance", &TreeIndex::distance, py::arg("node1"), py::arg("node2"),
+             py::arg("unrooted") = false)
+        .def("lca_batch", &TreeIndex::lcaBatch, py::arg("pairs"), py::arg("n_threads") = 0,
+             py::call_guard<py::gil_scoped_release>())
+        .def("distance_batch", &TreeIndex::distanceBatch, py::arg("pairs"),
+             py::arg("unrooted") = false, py::arg("n_threads") = 0,
+             py::call_guard<py::gil_scoped_release>())
+        .doc() = "Index of a tree answering common ancestor and distance queries in O(1)";
+
+    py::class_<DynamicTree>(m, "DynamicTree")
+        .def(py::init<const PhyloVec &, std::uint64_t>(), py::arg("v"), py::arg("seed") = 0)
+        .def_property_readonly("n_leaves", &DynamicTree::getNumLeaves)
+        .def_property_readonly("root", &DynamicTree::getRoot)
+        .def("leaf_node", &DynamicTree::getLeafNode, py::arg("leaf"))
+        .def("leaf_label", &DynamicTree::getLeafLabel, py::arg("node"))
+        .def("is_leaf", &DynamicTree::isLeaf, py::arg("node"))
+        .def("parent", &DynamicTree::getParent, py::arg("node"))
+        .def("children", &DynamicTree::getChildren, py::arg("node"))
+        .def("add_leaf", &DynamicTree::addLeaf, py::arg("leaf"), py::arg("pos"),
+             "Add a leaf as in add_leaf(v, leaf, pos) (O(n log n) if pos is above an internal "
+             "node and the tree changed since the last rebuild, O(log n) otherwise)")
+        .def("add_leaf_above", &DynamicTree::addLeafAbove, py::arg("leaf"), py::arg("sister"),
+             "Add a leaf with label leaf as the sister of a node, in O(log n)")
+        .def("remove_leaf", &DynamicTree::removeLeaf, py::arg("leaf"))
+        .def("to_vector", &DynamicTree::getVector)
+        .def_property_readonly("changed_offset", &DynamicTree::getChangedOffset)
+        .def(
+            "changed_suffix",
+            [](DynamicTree &tree) {
+                PhyloVec suffix;
+                size_t offset = tree.getChangedSuffix(suffix);
+                return std::make_pair(offset, suffix);
+            },
+            "Offset and entries of the vector that may have changed since the last call")
+        .doc() = "Tree edited leaf by leaf, with its vector rebuilt on demand";
+
+    py::class_<Neighbourhood>(m, "Neighbourhood")
+        .def(py::init<>())
+        .def("for_each",
+             py::overload_cast<const PhyloVec &, size_t, const NeighbourCallback &>(
+                 &Neighbourhood::forEach),
+             py::arg("v"), py::arg("index"), py::arg("callback"),
+             "Call callback(j, pairs) for each proposal v[index] = j, j in [0, 2 * index]")
+        .def("for_each",
+             py::overload_cast<const PhyloVec &, size_t, unsigned int, unsigned int,
+                               const NeighbourCallback &>(&Neighbourhood::forEach),
+             py::arg("v"), py::arg("index"), py::arg("begin"), py::arg("end"),
+             py::arg("callback"),
+             "Call callback(j, pairs) for each proposal v[index] = j, j in [begin, end)")
+        .doc() = "Pairs of the vectors obtained by changing one entry, built incrementally";
+
+    m.def("sample", py::overload_cast<const size_t &, bool>(&sample), py::arg("n_leaves"),
+          py::arg("ordered") = false, "Sample a random Phylo2Vec v for n leaves");
+
+    m.def("sample", py::overload_cast<const size_t &, bool, std::uint64_t, std::uint64_t>(&sample),
+          py::arg("n_leaves"), py::arg("ordered"), py::arg("seed"), py::arg("stream") = 0,
+          "Sample a random Phylo2Vec v for n leaves from a seeded stream");
+
+    m.def("sample_many", &sampleMany, py::arg("count"), py::arg("n_leaves"), py::arg("seed"),
+          py::arg("ordered") = false, py::arg("n_threads") = 0,
+          py::call_guard<py::gil_scoped_release>(),
+          "Sample many Phylo2Vec vectors in parallel (flattened, shape (count, n_leaves - 1))");
+
+    m.def(
+        "reorder",
+        [](PhyloVec v, const std::vector<std::string> &taxa, std::string_view method) {
+            Leaf2Taxon mapping(taxa.begin(), taxa.end());
+            reorder(v, mapping, method);
+            return std::make_pair(v, std::vector<std::string>(mapping.begin(), mapping.end()));
+        },
+        py::arg("v"), py::arg("taxa"), py::arg("method") = "birth_death",
+        "Relabel the leaves of v ('birth_death' or 'bfs'), returning the new v and taxa");
+
+    m.def(
+        "reorder_birth_death",
+        [](PhyloVec v, const std::vector<std::string> &taxa, std::uint64_t seed,
+           std::uint64_t stream) {
+            Leaf2Taxon mapping(taxa.begin(), taxa.end());
+            CounterRNG rng(seed, stream);
+            reorderBirthDeath(v, mapping, rng);
+            return std::make_pair(v, std::vector<std::string>(mapping.begin(), mapping.end()));
+        },
+        py::arg("v"), py::arg("taxa"), py::arg("seed"), py::arg("stream") = 0,
+        "Relabel the leaves of v as a birth-death process, visiting children in a random order");
+
+    m.def(
+        "reroot_at_random",
+        [](PhyloVec v, std::uint64_t seed, std::uint64_t stream) {
+            CounterRNG rng(seed, stream);
+            rerootAtRandom(v, rng);
+            return v;
+        },
+        py::arg("v"), py::arg("seed"), py::arg("stream") = 0,
+        "Reroot the tree of v above a random node from a seeded stream");
+
+    py::class_<NativeLoss>(m, "NativeLoss")
+        .def("__call__",
+             [](const NativeLoss &loss, const PhyloVec &v, const std::vector<unsigned int> &taxa) {
+                 return loss.fn(getPairs(v), taxa);
+             })
+        .doc() = "Tree loss evaluated in C++, as loss(v, taxa)";
+
+    m.def(
+        "bme_loss",
+        [](const std::vector<double> &distances, size_t numTaxa) {
+            return NativeLoss{makeBMELoss(distances, numTaxa)};
+        },
+        py::arg("distances"), py::arg("n_taxa"),
+        "Balanced minimum evolution loss from a flat (row-major n x n) distance matrix");
+
+    m.def(
+        "parsimony_loss",
+        [](const std::vector<std::string> &sequences) {
+            return NativeLoss{makeParsimonyLoss(sequences)};
+        },
+        py::arg("sequences"), "Fitch parsimony loss from aligned nucleotide sequences");
+
+    py::class_<HillClimbingProgress>(m, "HillClimbingProgress")
+        .def_readonly("pass_", &HillClimbingProgress::pass)
+        .def_readonly("round", &HillClimbingProgress::round)
+        .def_readonly("index", &HillClimbingProgress::index)
+        .def_readonly("loss", &HillClimbingProgress::loss)
+        .def_readonly("n_evaluations", &HillClimbingProgress::numEvaluations)
+        .def_readonly("seconds", &HillClimbingProgress::seconds);
+
+    auto hillClimbingBinding = [](const PhyloVec &v, const TreeLoss &loss,
+                                  const std::string &reorderMethod, double tol,
+                                  unsigned int patience, unsigned int rounds,
+                                  unsigned int numThreads, std::uint64_t seed,
+                                  const HillClimbingProgressCallback &progress) {
+        HillClimbingOptions options{reorderMethod, tol, patience, rounds, numThreads, seed};
+        HillClimbingResult result = hillClimbing(v, loss, options, progress);
+        return std::make_tuple(result.v, result.taxa, result.losses);
+    };
+
+    m.def(
+        "hill_climbing",
+        [=](const PhyloVec &v, const NativeLoss &loss, const std::string &reorderMethod,
+            double tol, unsigned int patience, unsigned int rounds, unsigned int numThreads,
+            std::uint64_t seed, const HillClimbingProgressCallback &progress) {
+            return hillClimbingBinding(v, loss.fn, reorderMethod, tol, patience, rounds,
+                                       numThreads, seed, progress);
+        },
+        py::arg("v"), py::arg("loss"), py::arg("reorder_method") = "birth_death",
+        py::arg("tol") = 0.001, py::arg("patience") = 3, py::arg("rounds") = 1,
+        py::arg("n_threads") = 0, py::arg("seed") = 0, py::arg("progress") = nullptr,
+        py::call_guard<py::gil_scoped_release>(),
+        "Minimise a loss by hill climbing over the entries of v, evaluating the proposals "
+        "of each entry in parallel; returns (v, taxa, losses), taxa[leaf] being a row "
+        "of the input data");
+
+    m.def("hill_climbing", hillClimbingBinding, py::arg("v"), py::arg("loss"),
+          py::arg("reorder_method") = "birth_death", py::arg("tol") = 0.001,
+          py::arg("patience") = 3, py::arg("rounds") = 1, py::arg("n_threads") = 0,
+          py::arg("seed") = 0, py::arg("progress") = nullptr,
+          py::call_guard<py::gil_scoped_release>(),
+          "Hill climbing with a Python loss(pairs, taxa) of the pairs of each tree "
+          "(called with the GIL held)");
 
     m.def("check_v", &check_v, "Check that Phylo2Vec v is correct");
 }
\ No newline at end of file
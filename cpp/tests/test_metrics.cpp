@@ -0,0 +1,616 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <set>
+
+#include "../base/to_newick.hpp"
+#include "../metrics/kendall_colijn.hpp"
+#include "../metrics/pairwise.hpp"
+#include "../metrics/robinson_foulds.hpp"
+#include "../metrics/shape.hpp"
+#include "../ops/vector.hpp"
+#include "../utils/mapped_file.hpp"
+#include "config.cpp"
+
+class MetricsTest : public ::testing::TestWithParam<int> {
+   protected:
+};
+
+INSTANTIATE_TEST_SUITE_P(RandomTests, MetricsTest, ::testing::Range(MIN_N_LEAVES, MAX_N_LEAVES));
+
+// Reference cophenetic distance: breadth-first search from each leaf over the tree's edges
+static Matrix naiveCophenetic(const PhyloVec &v, bool unrooted) {
+    const size_t numLeaves = v.size() + 1;
+    const size_t numNodes = 2 * numLeaves - 1;
+
+    Ancestry anc = getAncestry(v);
+    std::vector<std::vector<int>> neighbours(numNodes);
+    for (auto &[c1, c2, p] : anc) {
+        neighbours[c1].push_back(p);
+        neighbours[p].push_back(c1);
+        neighbours[c2].push_back(p);
+        neighbours[p].push_back(c2);
+    }
+
+    if (unrooted) {
+        // Replace the two root edges by a single edge
+        auto &[c1, c2, root] = anc.back();
+        neighbours[root].clear();
+        std::replace(neighbours[c1].begin(), neighbours[c1].end(), root, c2);
+        std::replace(neighbours[c2].begin(), neighbours[c2].end(), root, c1);
+    }
+
+    Matrix D(numLeaves);
+    std::vector<int> dist(numNodes);
+    std::vector<int> queue;
+    for (size_t i = 0; i < numLeaves; ++i) {
+        std::fill(dist.begin(), dist.end(), -1);
+        dist[i] = 0;
+        queue = {int(i)};
+        for (size_t q = 0; q < queue.size(); ++q) {
+            int node = queue[q];
+            for (int next : neighbours[node]) {
+                if (dist[next] == -1) {
+                    dist[next] = dist[node] + 1;
+                    queue.push_back(next);
+                }
+            }
+        }
+        D[i].assign(dist.begin(), dist.begin() + numLeaves);
+    }
+
+    return D;
+}
+
+TEST_P(MetricsTest, CopheneticTest) {
+    int numLeaves = GetParam();
+    for (size_t _ = 0; _ < N_REPEATS; ++_) {
+        PhyloVec v = sample(numLeaves, false);
+
+        // Alternate between rooted and unrooted distances
+        bool unrooted = _ % 2 == 1;
+
+        Matrix expected = naiveCophenetic(v, unrooted);
+
+        EXPECT_EQ(copheneticDistances(v, unrooted), expected);
+
+        std::vector<float> expectedSquare, expectedCondensed;
+        for (int i = 0; i < numLeaves; ++i) {
+            expectedSquare.insert(expectedSquare.end(), expected[i].begin(), expected[i].end());
+            expectedCondensed.insert(expectedCondensed.end(), expected[i].begin() + i + 1,
+                                     expected[i].end());
+        }
+
+        EXPECT_EQ(copheneticDistancesFlat(v, DistanceLayout::Square, unrooted), expectedSquare);
+        EXPECT_EQ(copheneticDistancesFlat(v, DistanceLayout::Condensed, unrooted),
+                  expectedCondensed);
+        EXPECT_EQ(expectedCondensed[getCondensedIndex(numLeaves, 1, numLeaves - 1)],
+                  expected[1][numLeaves - 1]);
+    }
+}
+
+TEST_P(MetricsTest, PatristicTest) {
+    int numLeaves = GetParam();
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_real_distribution<double> branchDistr(0.0, 1.0);
+
+    for (size_t _ = 0; _ < N_REPEATS; ++_) {
+        BasicPhyloMat<double> m;
+        m.v = sample(numLeaves, false);
+        m.branches.resize(numLeaves - 1);
+        for (auto &b : m.branches) {
+            b = {branchDistr(gen), branchDistr(gen)};
+        }
+
+        // Reference: sum the branch lengths up to the common ancestor
+        std::vector<int> parent(2 * numLeaves - 1, -1);
+        std::vector<double> branchToParent(2 * numLeaves - 1, 0);
+        Ancestry anc = getAncestry(m.v);
+        for (size_t i = 0; i < anc.size(); ++i) {
+            for (int j = 0; j < 2; ++j) {
+                parent[anc[i][j]] = anc[i][2];
+                branchToParent[anc[i][j]] = m.branches[i][j];
+            }
+        }
+        auto getAncestors = [&](int node) {
+            // Ancestors of a node, with their distance to it
+            std::vector<std::pair<int, double>> ancestors = {{node, 0}};
+            for (; parent[node] != -1; node = parent[node]) {
+                ancestors.push_back({parent[node], ancestors.back().second + branchToParent[node]});
+            }
+            return ancestors;
+        };
+
+        std::vector<std::vector<std::pair<int, double>>> leafAncestors;
+        for (int i = 0; i < numLeaves; ++i) {
+            leafAncestors.push_back(getAncestors(i));
+        }
+
+        std::vector<double> expected;
+        for (int i = 0; i < numLeaves; ++i) {
+            const auto &ancestorsI = leafAncestors[i];
+            for (int j = i + 1; j < numLeaves; ++j) {
+                const auto &ancestorsJ = leafAncestors[j];
+                auto itI = ancestorsI.rbegin(), itJ = ancestorsJ.rbegin();
+                while (std::next(itI)->first == std::next(itJ)->first) {
+                    ++itI;
+                    ++itJ;
+                }
+                expected.push_back(itI->second + itJ->second);
+            }
+        }
+
+        std::vector<double> condensed = patristicDistancesFlat(m, DistanceLayout::Condensed, 2);
+        ASSERT_EQ(condensed.size(), expected.size());
+        for (size_t k = 0; k < expected.size(); ++k) {
+            ASSERT_NEAR(condensed[k], expected[k], 1e-9);
+        }
+
+        // Same values in the square layout, and with float SoA branch lengths
+        std::vector<double> square = patristicDistancesFlat(m, DistanceLayout::Square);
+        auto mFloat = convertMatrix<float, BranchLayout::SoA>(m);
+        std::vector<float> squareFloat = patristicDistancesFlat(mFloat);
+        for (int i = 0; i < numLeaves; ++i) {
+            EXPECT_EQ(square[i * numLeaves + i], 0);
+            for (int j = i + 1; j < numLeaves; ++j) {
+                double d = condensed[getCondensedIndex(numLeaves, i, j)];
+                ASSERT_EQ(square[i * numLeaves + j], d);
+                ASSERT_EQ(square[j * numLeaves + i], d);
+                ASSERT_NEAR(squareFloat[i * numLeaves + j], d, 1e-4 * (1 + d));
+            }
+        }
+
+        // Unit branch lengths give the topological distances
+        PhyloMat unit{m.v, std::vector<std::array<float, 2>>(numLeaves - 1, {1, 1})};
+        EXPECT_EQ(pairwiseDistances(unit, "patristic"), copheneticDistances(m.v));
+    }
+}
+
+TEST_P(MetricsTest, DistanceFileTest) {
+    int numLeaves = GetParam();
+    PhyloVec v = sample(numLeaves, false);
+    BasicPhyloMat<double> m{v, std::vector<std::array<double, 2>>(numLeaves - 1, {0.25, 3})};
+
+    std::string path =
+        testing::TempDir() + "phylo2vec_distances_" + std::to_string(numLeaves) + ".bin";
+
+    // Read back the values of a distance file, checking its header
+    auto readValues = [&](auto zero, DistanceLayout layout) {
+        typedef decltype(zero) D;
+        MappedFile file(path);
+        DistanceHeader header;
+        EXPECT_GE(file.size(), sizeof(header));
+        std::memcpy(&header, file.data(), sizeof(header));
+        EXPECT_EQ(std::string(header.magic), "P2VDIST");
+        EXPECT_EQ(header.version, DISTANCE_FORMAT_VERSION);
+        EXPECT_EQ(header.numLeaves, numLeaves);
+        EXPECT_EQ(header.layout, layout == DistanceLayout::Square ? 0 : 1);
+        EXPECT_EQ(header.valueSize, sizeof(D));
+        EXPECT_EQ(header.count, getDistanceMatrixSize(numLeaves, layout));
+        EXPECT_EQ(file.size(), sizeof(header) + header.count * sizeof(D));
+        std::vector<D> values(header.count);
+        std::memcpy(values.data(), file.data() + sizeof(header), header.count * sizeof(D));
+        return values;
+    };
+
+    for (DistanceLayout layout : {DistanceLayout::Square, DistanceLayout::Condensed}) {
+        // Small chunks to go through several write-backs
+        std::vector<DistanceProgress> reports;
+        writeCopheneticDistances(
+            path, v, layout, true, 2, [&](const DistanceProgress &p) { reports.push_back(p); },
+            4096);
+        EXPECT_EQ(readValues(0.0f, layout), copheneticDistancesFlat(v, layout, true));
+
+        const size_t numBytes = getDistanceMatrixSize(numLeaves, layout) * sizeof(float);
+        ASSERT_GE(reports.size(), numBytes / 4096);
+        for (size_t i = 1; i < reports.size(); ++i) {
+            EXPECT_GT(reports[i].rowsDone, reports[i - 1].rowsDone);
+            EXPECT_GT(reports[i].bytesWritten, reports[i - 1].bytesWritten);
+        }
+        EXPECT_EQ(reports.back().rowsDone, numLeaves);
+        EXPECT_EQ(reports.back().numRows, numLeaves);
+        EXPECT_EQ(reports.back().bytesWritten, numBytes);
+
+        writePatristicDistances(path, m, layout);
+        EXPECT_EQ(readValues(0.0, layout), patristicDistancesFlat(m, layout));
+    }
+
+    // One row of branch lengths per cherry
+    m.branches.pop_back();
+    EXPECT_THROW(patristicDistancesFlat(m), std::invalid_argument);
+    EXPECT_THROW(writePatristicDistances(path, m), std::invalid_argument);
+
+    std::remove(path.c_str());
+}
+
+// Reference clusters (rooted) or splits (unrooted) as explicit sets of leaves
+static std::set<std::vector<int>> naiveSplits(const PhyloVec &v, bool unrooted) {
+    const int numLeaves = v.size() + 1;
+
+    std::vector<std::vector<int>> leaves(2 * numLeaves - 1);
+    for (int i = 0; i < numLeaves; ++i) {
+        leaves[i] = {i};
+    }
+
+    std::set<std::vector<int>> splits;
+    for (auto &[c1, c2, p] : getAncestry(v)) {
+        leaves[p] = leaves[c1];
+        leaves[p].insert(leaves[p].end(), leaves[c2].begin(), leaves[c2].end());
+        std::sort(leaves[p].begin(), leaves[p].end());
+
+        std::vector<int> split = leaves[p];
+        if (unrooted && split[0] == 0) {
+            // Complement
+            split.clear();
+            for (int leaf = 0; leaf < numLeaves; ++leaf) {
+                if (!std::binary_search(leaves[p].begin(), leaves[p].end(), leaf)) {
+                    split.push_back(leaf);
+                }
+            }
+        }
+        // Both sides of a split need at least two leaves
+        if (split.size() > 1 && int(split.size()) < (unrooted ? numLeaves - 1 : numLeaves)) {
+            splits.insert(split);
+        }
+    }
+
+    return splits;
+}
+
+TEST_P(MetricsTest, RobinsonFouldsTest) {
+    int numLeaves = GetParam();
+
+    for (size_t _ = 0; _ < N_REPEATS; ++_) {
+        PhyloVec v1 = sample(numLeaves, false);
+        PhyloVec v2 = sample(numLeaves, false);
+
+        for (bool unrooted : {false, true}) {
+            std::set<std::vector<int>> splits1 = naiveSplits(v1, unrooted);
+            std::set<std::vector<int>> splits2 = naiveSplits(v2, unrooted);
+            std::vector<std::vector<int>> common;
+            std::set_intersection(splits1.begin(), splits1.end(), splits2.begin(), splits2.end(),
+                                  std::back_inserter(common));
+
+            EXPECT_EQ(getSplitHashes(v1, unrooted).size(), splits1.size());
+            EXPECT_EQ(robinsonFoulds(v1, v2, unrooted),
+                      splits1.size() + splits2.size() - 2 * common.size());
+            EXPECT_EQ(robinsonFoulds(v1, v1, unrooted), 0);
+        }
+    }
+}
+
+TEST(MetricsTest, RobinsonFouldsSmallTest) {
+    for (bool unrooted : {false, true}) {
+        EXPECT_TRUE(getSplitHashes(PhyloVec{}, unrooted).empty());
+        EXPECT_EQ(robinsonFoulds(PhyloVec{}, PhyloVec{}, unrooted), 0);
+        EXPECT_EQ(robinsonFoulds(PhyloVec{0}, PhyloVec{0}, unrooted), 0);
+        EXPECT_EQ(robinsonFouldsAllPairs({PhyloVec{}, PhyloVec{}}, unrooted),
+                  (std::vector<unsigned int>(4, 0)));
+    }
+}
+
+TEST(MetricsTest, RobinsonFouldsAllPairsTest) {
+    // Copies of a few trees share few distinct splits (compared as bitsets),
+    // pairs of copies of many trees share many (compared as sorted lists),
+    // and random trees share almost none
+    const size_t numTrees = 200;
+    for (size_t numDistinct : {3, 100, 200}) {
+        std::vector<PhyloVec> vs;
+        for (size_t i = 0; i < numTrees; ++i) {
+            vs.push_back(sample(50, false, 42, i % numDistinct));
+        }
+
+        for (bool unrooted : {false, true}) {
+            std::vector<unsigned int> distances = robinsonFouldsAllPairs(vs, unrooted, 4);
+            ASSERT_EQ(distances.size(), numTrees * numTrees);
+            for (size_t i = 0; i < numTrees; ++i) {
+                EXPECT_EQ(distances[i * numTrees + i], 0);
+                for (size_t j = i + 1; j < numTrees; ++j) {
+                    ASSERT_EQ(distances[i * numTrees + j], robinsonFoulds(vs[i], vs[j], unrooted));
+                    ASSERT_EQ(distances[j * numTrees + i], distances[i * numTrees + j]);
+                }
+            }
+        }
+    }
+
+    EXPECT_TRUE(robinsonFouldsAllPairs({}).empty());
+    EXPECT_THROW(robinsonFouldsAllPairs({sample(5, false), sample(6, false)}),
+                 std::invalid_argument);
+    EXPECT_THROW(robinsonFoulds(sample(5, false), sample(6, false)), std::invalid_argument);
+}
+
+// Reference Kendall-Colijn vector: walk up from both leaves of each pair to their common ancestor
+static std::vector<double> naiveKendallColijn(const BasicPhyloMat<double> &m, double lambda) {
+    const int numLeaves = m.v.size() + 1;
+
+    std::vector<int> parent(2 * numLeaves - 1, -1);
+    std::vector<double> branchToParent(2 * numLeaves - 1, 0);
+    Ancestry anc = getAncestry(m.v);
+    for (size_t i = 0; i < anc.size(); ++i) {
+        for (int j = 0; j < 2; ++j) {
+            parent[anc[i][j]] = anc[i][2];
+            branchToParent[anc[i][j]] = (1 - lambda) + lambda * m.branches[i][j];
+        }
+    }
+
+    // Distance from each node to the root (parents have higher labels)
+    std::vector<double> rootDistance(2 * numLeaves - 1, 0);
+    for (int node = 2 * numLeaves - 3; node >= 0; --node) {
+        rootDistance[node] = rootDistance[parent[node]] + branchToParent[node];
+    }
+
+    std::vector<std::vector<int>> leafAncestors(numLeaves);
+    for (int i = 0; i < numLeaves; ++i) {
+        for (int node = i; node != -1; node = parent[node]) {
+            leafAncestors[i].push_back(node);
+        }
+    }
+
+    std::vector<double> expected;
+    for (int i = 0; i < numLeaves; ++i) {
+        for (int j = i + 1; j < numLeaves; ++j) {
+            auto itI = leafAncestors[i].rbegin(), itJ = leafAncestors[j].rbegin();
+            while (std::next(itI) != leafAncestors[i].rend() &&
+                   std::next(itJ) != leafAncestors[j].rend() &&
+                   *std::next(itI) == *std::next(itJ)) {
+                ++itI;
+                ++itJ;
+            }
+            expected.push_back(rootDistance[*itI]);
+        }
+    }
+    for (int i = 0; i < numLeaves; ++i) {
+        expected.push_back(branchToParent[i]);
+    }
+
+    return expected;
+}
+
+static double naiveEuclidean(const std::vector<double> &x, const std::vector<double> &y) {
+    double sum = 0;
+    for (size_t k = 0; k < x.size(); ++k) {
+        sum += (x[k] - y[k]) * (x[k] - y[k]);
+    }
+    return std::sqrt(sum);
+}
+
+TEST_P(MetricsTest, KendallColijnTest) {
+    int numLeaves = GetParam();
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_real_distribution<double> branchDistr(0.0, 1.0);
+
+    auto sampleMatrix = [&]() {
+        BasicPhyloMat<double> m;
+        m.v = sample(numLeaves, false);
+        m.branches.resize(numLeaves - 1);
+        for (auto &b : m.branches) {
+            b = {branchDistr(gen), branchDistr(gen)};
+        }
+        return m;
+    };
+
+    for (size_t _ = 0; _ < N_REPEATS; ++_) {
+        BasicPhyloMat<double> m1 = sampleMatrix();
+        BasicPhyloMat<double> m2 = sampleMatrix();
+
+        // Cycle through topological, mixed and branch length vectors
+        const double lambda = 0.5 * (_ % 3);
+
+        std::vector<double> expected1 = naiveKendallColijn(m1, lambda);
+        std::vector<double> expected2 = naiveKendallColijn(m2, lambda);
+        double expectedDistance = naiveEuclidean(expected1, expected2);
+
+        std::vector<float> vector1 =
+            kendallColijnVector(convertMatrix<double, BranchLayout::SoA>(m1), lambda, 2);
+        ASSERT_EQ(vector1.size(), getKendallColijnSize(numLeaves));
+        for (size_t k = 0; k < expected1.size(); ++k) {
+            ASSERT_NEAR(vector1[k], expected1[k], 1e-5 * (1 + expected1[k]));
+        }
+        EXPECT_NEAR(kendallColijn(m1, m2, lambda), expectedDistance,
+                    1e-5 * (1 + expectedDistance));
+        EXPECT_EQ(kendallColijn(m1, m1, lambda), 0);
+
+        if (lambda == 0) {
+            // Integer entries are exact
+            std::vector<float> topological = kendallColijnVector(m1.v);
+            EXPECT_EQ(std::vector<double>(topological.begin(), topological.end()), expected1);
+            EXPECT_EQ(topological, vector1);
+            EXPECT_NEAR(kendallColijn(m1.v, m2.v), expectedDistance, 1e-9 * expectedDistance);
+        }
+    }
+}
+
+TEST(MetricsTest, KendallColijnAllPairsTest) {
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> branchDistr(0.0, 1.0);
+
+    const size_t numTrees = 30;
+    std::vector<PhyloVec> vs;
+    std::vector<PhyloMat> ms;
+    for (size_t i = 0; i < numTrees; ++i) {
+        vs.push_back(sample(50, false, 42, i));
+        PhyloMat m{vs.back(), std::vector<std::array<float, 2>>(49)};
+        for (auto &b : m.branches) {
+            b = {branchDistr(gen), branchDistr(gen)};
+        }
+        ms.push_back(m);
+    }
+
+    std::vector<double> distances = kendallColijnAllPairs(vs, 4);
+    std::vector<double> mixedDistances = kendallColijnAllPairs(ms, 0.5, 4);
+    ASSERT_EQ(distances.size(), numTrees * numTrees);
+    ASSERT_EQ(mixedDistances.size(), numTrees * numTrees);
+    for (size_t i = 0; i < numTrees; ++i) {
+        EXPECT_EQ(distances[i * numTrees + i], 0);
+        for (size_t j = i + 1; j < numTrees; ++j) {
+            ASSERT_EQ(distances[i * numTrees + j], kendallColijn(vs[i], vs[j]));
+            ASSERT_EQ(distances[j * numTrees + i], distances[i * numTrees + j]);
+            ASSERT_DOUBLE_EQ(mixedDistances[i * numTrees + j], kendallColijn(ms[i], ms[j], 0.5));
+            ASSERT_EQ(mixedDistances[j * numTrees + i], mixedDistances[i * numTrees + j]);
+        }
+    }
+
+    EXPECT_TRUE(kendallColijnAllPairs(std::vector<PhyloVec>()).empty());
+    EXPECT_THROW(kendallColijnAllPairs({sample(5, false), sample(6, false)}),
+                 std::invalid_argument);
+    EXPECT_THROW(kendallColijn(sample(5, false), sample(6, false)), std::invalid_argument);
+    EXPECT_THROW(kendallColijnAllPairs(ms, 1.5), std::invalid_argument);
+
+    // One row of branch lengths per cherry
+    ms[1].branches.pop_back();
+    EXPECT_THROW(kendallColijnVector(ms[1], 0.5), std::invalid_argument);
+    EXPECT_THROW(kendallColijn(ms[0], ms[1], 0.5), std::invalid_argument);
+    EXPECT_THROW(kendallColijnAllPairs(ms, 0.5), std::invalid_argument);
+}
+
+TEST(MetricsTest, KendallColijnBlocksTest) {
+    // Vectors of 2000 leaves do not all fit in the memory budget of kendallColijnAllPairs
+    const size_t numTrees = 20;
+    std::vector<PhyloVec> vs;
+    std::vector<std::vector<double>> vectors;
+    for (size_t i = 0; i < numTrees; ++i) {
+        vs.push_back(sample(2000, false, 42, i));
+        std::vector<float> vector = kendallColijnVector(vs.back());
+        vectors.emplace_back(vector.begin(), vector.end());
+    }
+
+    std::vector<double> distances = kendallColijnAllPairs(vs, 2);
+    for (size_t i = 0; i < numTrees; ++i) {
+        for (size_t j = i + 1; j < numTrees; ++j) {
+            double distance = naiveEuclidean(vectors[i], vectors[j]);
+            ASSERT_NEAR(distances[i * numTrees + j], distance, 1e-9 * distance);
+            ASSERT_EQ(distances[j * numTrees + i], distances[i * numTrees + j]);
+        }
+    }
+}
+
+TEST_P(MetricsTest, ShapeStatsTest) {
+    int numLeaves = GetParam();
+    std::vector<PhyloVec> vs;
+    for (size_t _ = 0; _ < N_REPEATS; ++_) {
+        PhyloVec v = sample(numLeaves, false);
+        vs.push_back(v);
+
+        // Reference: leaf counts and depths from the ancestry
+        Ancestry anc = getAncestry(v);
+        std::vector<int> parent(2 * numLeaves - 1, -1);
+        std::vector<unsigned int> sizes(2 * numLeaves - 1, 1);
+        uint64_t colless = 0;
+        unsigned int numCherries = 0;
+        for (auto &[c1, c2, p] : anc) {
+            parent[c1] = parent[c2] = p;
+            sizes[p] = sizes[c1] + sizes[c2];
+            colless += std::abs(int(sizes[c1]) - int(sizes[c2]));
+            numCherries += c1 < numLeaves && c2 < numLeaves;
+        }
+
+        uint64_t sackin = 0;
+        unsigned int height = 0;
+        std::vector<unsigned int> depthCounts(numLeaves, 0);
+        for (int i = 0; i < numLeaves; ++i) {
+            unsigned int depth = 0;
+            for (int node = i; parent[node] != -1; node = parent[node]) {
+                ++depth;
+            }
+            sackin += depth;
+            height = std::max(height, depth);
+            ++depthCounts[depth];
+        }
+
+        ShapeStats stats = getShapeStats(v);
+        EXPECT_EQ(stats.sackin, sackin);
+        EXPECT_EQ(stats.colless, colless);
+        EXPECT_EQ(stats.numCherries, numCherries);
+        EXPECT_EQ(stats.height, height);
+        EXPECT_EQ(getLeafDepthCounts(v), depthCounts);
+    }
+
+    // Batches (of vectors and of a contiguous block) match the single-tree statistics
+    std::vector<unsigned int> block;
+    for (const auto &v : vs) {
+        block.insert(block.end(), v.begin(), v.end());
+    }
+    ShapeStatsBatch batch = getShapeStatsBatch(vs, true, 2);
+    ShapeStatsBatch blockBatch = getShapeStatsBatch(block.data(), vs.size(), numLeaves, true, 2);
+    ASSERT_EQ(batch.size(), vs.size());
+    for (const ShapeStatsBatch &b : {batch, blockBatch}) {
+        for (size_t t = 0; t < vs.size(); ++t) {
+            ShapeStats stats = getShapeStats(vs[t]);
+            EXPECT_EQ(b.sackin[t], stats.sackin);
+            EXPECT_EQ(b.colless[t], stats.colless);
+            EXPECT_EQ(b.numCherries[t], stats.numCherries);
+            EXPECT_EQ(b.height[t], stats.height);
+            std::vector<unsigned int> depthCounts(b.depthCounts.begin() + b.depthOffsets[t],
+                                                  b.depthCounts.begin() + b.depthOffsets[t + 1]);
+            EXPECT_EQ(depthCounts, getLeafDepthCounts(vs[t]));
+        }
+    }
+    EXPECT_TRUE(getShapeStatsBatch(vs).depthCounts.empty());
+}
+
+TEST(MetricsTest, ShapeStatsEdgeCasesTest) {
+    // Caterpillar: leaf depths 1, 2, ..., n - 1, n - 1
+    PhyloVec ladder(5, 0);
+    ShapeStats stats = getShapeStats(ladder);
+    EXPECT_EQ(stats.sackin, 1 + 2 + 3 + 4 + 5 + 5);
+    EXPECT_EQ(stats.colless, 4 + 3 + 2 + 1 + 0);
+    EXPECT_EQ(stats.numCherries, 1);
+    EXPECT_EQ(stats.height, 5);
+
+    // Cherry
+    stats = getShapeStats(PhyloVec{0});
+    EXPECT_EQ(stats.sackin, 2);
+    EXPECT_EQ(stats.colless, 0);
+    EXPECT_EQ(stats.numCherries, 1);
+    EXPECT_EQ(getLeafDepthCounts(PhyloVec{0}), (std::vector<unsigned int>{0, 2}));
+
+    // Single leaf
+    stats = getShapeStats(PhyloVec{});
+    EXPECT_EQ(stats.sackin, 0);
+    EXPECT_EQ(stats.colless, 0);
+    EXPECT_EQ(stats.numCherries, 0);
+    EXPECT_EQ(stats.height, 0);
+    EXPECT_EQ(getLeafDepthCounts(PhyloVec{}), (std::vector<unsigned int>{1}));
+
+    ShapeStatsBatch batch = getShapeStatsBatch({PhyloVec{}, PhyloVec{0}, PhyloVec{}}, true);
+    EXPECT_EQ(batch.sackin, (std::vector<uint64_t>{0, 2, 0}));
+    EXPECT_EQ(batch.depthCounts, (std::vector<unsigned int>{1, 0, 2, 1}));
+
+    EXPECT_EQ(getShapeStatsBatch(std::vector<PhyloVec>()).size(), 0);
+
+    // Contiguous single-leaf trees have no entries
+    batch = getShapeStatsBatch(nullptr, 2, 1, true);
+    EXPECT_EQ(batch.sackin, (std::vector<uint64_t>{0, 0}));
+    EXPECT_EQ(batch.height, (std::vector<unsigned int>{0, 0}));
+    EXPECT_EQ(batch.depthCounts, (std::vector<unsigned int>{1, 1}));
+    EXPECT_THROW(getShapeStatsBatch(nullptr, 0, 0), std::invalid_argument);
+}
+
+TEST(MetricsTest, PairwiseDistancesTest) {
+    PhyloVec v = sample(5, false);
+    EXPECT_EQ(pairwiseDistances(v, "cophenetic"), copheneticDistances(v));
+    EXPECT_THROW(pairwiseDistances(v, "foo"), std::invalid_argument);
+
+    PhyloMat m{v, std::vector<std::array<float, 2>>(4, {0.5, 2})};
+    EXPECT_EQ(pairwiseDistances(m, "cophenetic", true), copheneticDistances(v, true));
+    EXPECT_EQ(pairwiseDistances(m, "patristic")[0][0], 0);
+    EXPECT_THROW(pairwiseDistances(m, "foo"), std::invalid_argument);
+
+    std::vector<PhyloVec> vs = {v, sample(5, false), sample(5, false)};
+    Matrix rf = pairwiseTreeDistances(vs, "robinson_foulds", true);
+    EXPECT_EQ(rf[0][1], robinsonFoulds(vs[0], vs[1], true));
+    Matrix kc = pairwiseTreeDistances(vs, "kendall_colijn");
+    EXPECT_FLOAT_EQ(kc[2][1], kendallColijn(vs[2], vs[1]));
+    EXPECT_THROW(pairwiseTreeDistances(vs, "kendall_colijn", true), std::invalid_argument);
+    EXPECT_THROW(pairwiseTreeDistances(vs, "foo"), std::invalid_argument);
+
+    std::vector<PhyloMat> ms = {m, m};
+    EXPECT_EQ(pairwiseTreeDistances(ms, "kendall_colijn", 0.5)[0][1], 0);
+    EXPECT_EQ(pairwiseTreeDistances(ms, "robinson_foulds")[1][0], 0);
+}
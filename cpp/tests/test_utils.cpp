@@ -1,8 +1,20 @@
 #include <gtest/gtest.h>
 
+#include <cstdio>
+#include <numeric>
 #include <random>
 
+#include "../base/to_newick.hpp"
+#include "../base/to_vector.hpp"
+#include "../io/packed.hpp"
+#include "../metrics/pairwise.hpp"
+#include "../ops/dynamic_tree.hpp"
+#include "../ops/neighbourhood.hpp"
+#include "../ops/tree_index.hpp"
 #include "../ops/vector.hpp"
+#include "../opt/hill_climbing.hpp"
+#include "../opt/losses.hpp"
+#include "../utils/parallel.hpp"
 #include "config.cpp"
 
 class UtilsTest : public ::testing::TestWithParam<int> {
@@ -20,6 +32,43 @@ TEST_P(UtilsTest, SampleTest) {
     }
 }
 
+TEST_P(UtilsTest, SeededSampleTest) {
+    int numLeaves = GetParam();
+
+    for (bool ordered : {false, true}) {
+        PhyloVec v = sample(numLeaves, ordered, 42, 7);
+
+        EXPECT_NO_THROW(check_v(v));
+        EXPECT_EQ(v, sample(numLeaves, ordered, 42, 7));
+        EXPECT_NE(v, sample(numLeaves, ordered, 42, 8));
+    }
+}
+
+TEST_P(UtilsTest, SampleManyTest) {
+    int numLeaves = GetParam();
+    const size_t k = numLeaves - 1;
+
+    std::vector<unsigned int> vs = sampleMany(N_REPEATS, numLeaves, 42, false, 1);
+
+    // Same output with several threads
+    EXPECT_EQ(vs, sampleMany(N_REPEATS, numLeaves, 42, false, 4));
+
+    for (size_t i = 0; i < N_REPEATS; ++i) {
+        PhyloVec v(vs.begin() + i * k, vs.begin() + (i + 1) * k);
+        EXPECT_EQ(v, sample(numLeaves, false, 42, i));
+    }
+}
+
+TEST(UtilsTest, SampleSmallTest) {
+    EXPECT_EQ(sample(1), PhyloVec{});
+    EXPECT_EQ(sample(1, true, 42), PhyloVec{});
+    EXPECT_EQ(sample(2), PhyloVec{0});
+    EXPECT_EQ(sample(2, false, 42), PhyloVec{0});
+
+    EXPECT_TRUE(sampleMany(N_REPEATS, 1, 42, false, 4).empty());
+    EXPECT_EQ(sampleMany(N_REPEATS, 2, 42), std::vector<unsigned int>(N_REPEATS, 0));
+}
+
 TEST_P(UtilsTest, RemoveAndAddTest) {
     int numLeaves = GetParam();
     std::random_device rd;
@@ -44,4 +93,503 @@ TEST_P(UtilsTest, RemoveAndAddTest) {
 
         EXPECT_EQ(v, vOld);
     }
-}
\ No newline at end of file
+}
+
+TEST_P(UtilsTest, ReorderTest) {
+    int numLeaves = GetParam();
+
+    std::vector<std::string> taxa(numLeaves);
+    for (int i = 0; i < numLeaves; ++i) {
+        taxa[i] = std::to_string(i);
+    }
+
+    for (size_t _ = 0; _ < N_REPEATS; ++_) {
+        PhyloVec v = sample(numLeaves, false);
+        Matrix D = copheneticDistances(v);
+
+        CounterRNG rng(42, _);
+        for (std::string_view method : {"birth_death", "bfs", "shuffled"}) {
+            PhyloVec vNew = v;
+            Leaf2Taxon mapping(taxa.begin(), taxa.end());
+            if (method == "shuffled") {
+                reorderBirthDeath(vNew, mapping, rng);
+            } else {
+                reorder(vNew, mapping, method);
+            }
+
+            EXPECT_NO_THROW(check_v(vNew));
+            if (method != "bfs") {
+                for (size_t i = 0; i < vNew.size(); ++i) {
+                    ASSERT_LE(vNew[i], i);
+                }
+            }
+
+            // Same tree: leaf i is now the leaf whose taxon is i
+            std::vector<unsigned int> oldLabel(numLeaves);
+            for (int i = 0; i < numLeaves; ++i) {
+                oldLabel[i] = std::stoi(std::string(mapping[i]));
+            }
+            Matrix DNew = copheneticDistances(vNew);
+            for (int i = 0; i < numLeaves; ++i) {
+                for (int j = 0; j < numLeaves; ++j) {
+                    ASSERT_EQ(DNew[i][j], D[oldLabel[i]][oldLabel[j]]);
+                }
+            }
+        }
+
+        // A birth-death reordering is its own reordering
+        PhyloVec vNew = v;
+        Leaf2Taxon noMapping;
+        reorderBirthDeath(vNew, noMapping);
+        PhyloVec vOnce = vNew;
+        reorderBirthDeath(vNew, noMapping);
+        EXPECT_EQ(vNew, vOnce);
+    }
+
+    PhyloVec v = sample(numLeaves, false);
+    Leaf2Taxon mapping(taxa.begin(), taxa.end());
+    EXPECT_THROW(reorder(v, mapping, "dfs"), std::invalid_argument);
+    mapping.pop_back();
+    EXPECT_THROW(reorder(v, mapping, "bfs"), std::invalid_argument);
+
+    // Single leaf
+    if (numLeaves == MIN_N_LEAVES) {
+        for (std::string_view method : {"birth_death", "bfs"}) {
+            PhyloVec vSingle;
+            Leaf2Taxon singleMapping{"a"};
+            reorder(vSingle, singleMapping, method);
+            EXPECT_TRUE(vSingle.empty());
+            EXPECT_EQ(singleMapping, Leaf2Taxon{"a"});
+        }
+        PhyloVec vSingle;
+        Leaf2Taxon singleMapping{"a"};
+        reorderBirthDeath(vSingle, singleMapping);
+        EXPECT_TRUE(vSingle.empty());
+        CounterRNG rng(42);
+        rerootAtRandom(vSingle, rng);
+        EXPECT_TRUE(vSingle.empty());
+    }
+}
+
+TEST_P(UtilsTest, RerootAtRandomTest) {
+    int numLeaves = GetParam();
+
+    for (size_t _ = 0; _ < N_REPEATS; ++_) {
+        PhyloVec v = sample(numLeaves, false);
+        Matrix D = copheneticDistances(v, true);
+
+        CounterRNG rng(42, _);
+        PhyloVec vNew = v;
+        rerootAtRandom(vNew, rng);
+
+        // Same unrooted tree
+        EXPECT_NO_THROW(check_v(vNew));
+        EXPECT_EQ(copheneticDistances(vNew, true), D);
+
+        // Same output from the same stream
+        PhyloVec vSeeded = v;
+        CounterRNG rng2(42, _);
+        rerootAtRandom(vSeeded, rng2);
+        EXPECT_EQ(vSeeded, vNew);
+    }
+}
+
+TEST_P(UtilsTest, DynamicTreeTest) {
+    int numLeaves = GetParam();
+    std::random_device rd;
+    std::mt19937 gen(rd());
+
+    for (size_t _ = 0; _ < N_REPEATS; ++_) {
+        PhyloVec v = sample(numLeaves, false);
+        DynamicTree tree(v, _);
+
+        ASSERT_EQ(tree.getNumLeaves(), numLeaves);
+        ASSERT_EQ(tree.getChangedOffset(), v.size());
+        ASSERT_EQ(tree.getVector(), v);
+
+        // Apply the same edits to the tree and the vector, emitting changed suffixes
+        PhyloVec emitted = v, suffix;
+        for (size_t step = 0; step < 20; ++step) {
+            const unsigned int n = v.size() + 1;
+            if (n > 2 && gen() % 2 == 0) {
+                unsigned int leaf = gen() % n;
+                tree.removeLeaf(leaf);
+                removeLeaf(v, leaf);
+            } else {
+                unsigned int leaf = gen() % (n + 1);
+                unsigned int pos = gen() % (2 * n - 1);
+                tree.addLeaf(leaf, pos);
+                addLeaf(v, leaf, pos);
+            }
+            ASSERT_EQ(tree.getNumLeaves(), v.size() + 1);
+
+            if (step % 3 == 0) {
+                size_t offset = tree.getChangedSuffix(suffix);
+                ASSERT_LE(offset, emitted.size());
+                // Entries before the offset did not change
+                emitted.resize(offset);
+                emitted.insert(emitted.end(), suffix.begin(), suffix.end());
+                ASSERT_EQ(emitted, v);
+                ASSERT_EQ(tree.getChangedOffset(), v.size());
+            }
+        }
+        ASSERT_EQ(tree.getVector(), v);
+
+        // Leaf nodes and labels are inverse of each other
+        const unsigned int n = tree.getNumLeaves();
+        for (unsigned int leaf = 0; leaf < n; ++leaf) {
+            DynamicTree::NodeId node = tree.getLeafNode(leaf);
+            ASSERT_TRUE(tree.isLeaf(node));
+            ASSERT_EQ(tree.getLeafLabel(node), leaf);
+        }
+
+        // Adding a leaf above a node, then removing it, gives back the same tree
+        unsigned int leaf = gen() % (n + 1);
+        DynamicTree::NodeId sister = tree.getParent(tree.getLeafNode(gen() % n));
+        DynamicTree::NodeId node = tree.addLeafAbove(leaf, sister);
+        ASSERT_EQ(tree.getLeafLabel(node), leaf);
+        ASSERT_EQ(tree.getParent(sister), tree.getParent(node));
+        ASSERT_EQ(tree.removeLeaf(leaf), sister);
+        ASSERT_EQ(tree.getVector(), v);
+
+        EXPECT_THROW(tree.getLeafNode(n), std::out_of_range);
+        EXPECT_THROW(tree.addLeaf(0, 2 * n - 1), std::out_of_range);
+    }
+
+    DynamicTree cherry(PhyloVec{0});
+    EXPECT_THROW(cherry.removeLeaf(0), std::invalid_argument);
+}
+
+TEST_P(UtilsTest, NeighbourhoodTest) {
+    int numLeaves = GetParam();
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_int_distribution<size_t> indexDistr(0, numLeaves - 2);
+
+    Neighbourhood neighbourhood;
+    for (size_t _ = 0; _ < N_REPEATS; ++_) {
+        PhyloVec v = sample(numLeaves, false);
+
+        // One object sweeps several indices, including the first and (once) the last
+        std::vector<size_t> indices = {indexDistr(gen), 0};
+        if (_ == 0) {
+            indices.push_back(numLeaves - 2);
+        }
+        for (size_t index : indices) {
+            unsigned int expected = 0;
+            neighbourhood.forEach(v, index, [&](unsigned int j, const Pairs &pairs) {
+                ASSERT_EQ(j, expected++);
+                PhyloVec proposal = v;
+                proposal[index] = j;
+                ASSERT_EQ(pairs, getPairs(proposal));
+            });
+            EXPECT_EQ(expected, 2 * index + 1);
+        }
+
+        // A random range of proposals, after the scratch space was used by another index
+        const size_t index = indexDistr(gen);
+        std::uniform_int_distribution<unsigned int> proposalDistr(0, 2 * index + 1);
+        unsigned int begin = proposalDistr(gen), end = proposalDistr(gen);
+        if (begin > end) {
+            std::swap(begin, end);
+        }
+        unsigned int expected = begin;
+        neighbourhood.forEach(v, index, begin, end, [&](unsigned int j, const Pairs &pairs) {
+            ASSERT_EQ(j, expected++);
+            PhyloVec proposal = v;
+            proposal[index] = j;
+            ASSERT_EQ(pairs, getPairs(proposal));
+        });
+        EXPECT_EQ(expected, end);
+    }
+
+    PhyloVec v = sample(numLeaves, false);
+    EXPECT_THROW(neighbourhood.forEach(v, v.size(), [](unsigned int, const Pairs &) {}),
+                 std::out_of_range);
+    EXPECT_THROW(neighbourhood.forEach(v, 1, 2, 4, [](unsigned int, const Pairs &) {}),
+                 std::out_of_range);
+}
+
+TEST_P(UtilsTest, PackedVectorsTest) {
+    int numLeaves = GetParam();
+
+    std::vector<PhyloVec> vs;
+    for (size_t i = 0; i < N_REPEATS; ++i) {
+        vs.push_back(sample(numLeaves, false));
+    }
+    // Largest possible entries use the full width
+    PhyloVec vMax(numLeaves - 1);
+    for (size_t i = 0; i < vMax.size(); ++i) {
+        vMax[i] = 2 * i;
+    }
+    vs.push_back(vMax);
+
+    std::vector<char> record(getPackedRecordSize(numLeaves));
+    EXPECT_LT(record.size(), vMax.size() * sizeof(unsigned int));
+
+    for (const auto &v : vs) {
+        std::fill(record.begin(), record.end(), 0);
+        packVector(v, record.data());
+
+        PhyloVec unpacked;
+        unpackVector(record.data(), numLeaves, unpacked);
+        EXPECT_EQ(unpacked, v);
+    }
+
+    std::string path =
+        testing::TempDir() + "phylo2vec_packed_" + std::to_string(numLeaves) + ".bin";
+    writePackedVectors(path, vs, 4);
+
+    PackedVectorFile file(path);
+    ASSERT_EQ(file.size(), vs.size());
+    EXPECT_EQ(file.getNumLeaves(), static_cast<size_t>(numLeaves));
+    for (size_t i = vs.size(); i-- > 0;) {
+        EXPECT_EQ(file.get(i), vs[i]);
+    }
+    EXPECT_THROW(file.get(vs.size()), std::out_of_range);
+
+    std::remove(path.c_str());
+}
+
+TEST_P(UtilsTest, TreeIndexTest) {
+    int numLeaves = GetParam();
+    const unsigned int numNodes = 2 * numLeaves - 1;
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_int_distribution<unsigned int> nodeDistr(0, numNodes - 1);
+
+    for (size_t _ = 0; _ < N_REPEATS; ++_) {
+        PhyloVec v = sample(numLeaves, false);
+        TreeIndex index(v);
+
+        ASSERT_EQ(index.getNumLeaves(), numLeaves);
+        ASSERT_EQ(index.getNumNodes(), numNodes);
+        ASSERT_EQ(index.getRoot(), numNodes - 1);
+
+        // Reference: walk up from the deeper node
+        std::vector<unsigned int> parent(numNodes, numNodes - 1);
+        for (auto &[c1, c2, p] : getAncestry(v)) {
+            parent[c1] = p;
+            parent[c2] = p;
+        }
+        std::vector<unsigned int> depth(numNodes, 0);
+        for (int node = numNodes - 2; node >= 0; --node) {
+            depth[node] = depth[parent[node]] + 1;
+            EXPECT_EQ(index.getParent(node), parent[node]);
+            EXPECT_EQ(index.getDepth(node), depth[node]);
+        }
+        auto naiveLCA = [&](unsigned int a, unsigned int b) {
+            while (a != b) {
+                if (depth[a] >= depth[b]) {
+                    a = parent[a];
+                } else {
+                    b = parent[b];
+                }
+            }
+            return a;
+        };
+
+        Pairs pairs(1000);
+        for (auto &pair : pairs) {
+            pair = {nodeDistr(gen), nodeDistr(gen)};
+        }
+        pairs[0] = {0, 0};
+        pairs[1] = {numNodes - 1, 0};
+
+        std::vector<unsigned int> ancestors = index.lcaBatch(pairs, 4);
+        std::vector<unsigned int> distances = index.distanceBatch(pairs, false, 4);
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            auto [a, b] = pairs[i];
+            unsigned int expected = naiveLCA(a, b);
+            EXPECT_EQ(index.lca(a, b), expected);
+            EXPECT_EQ(ancestors[i], expected);
+            EXPECT_EQ(distances[i], depth[a] + depth[b] - 2 * depth[expected]);
+        }
+        EXPECT_EQ(getCommonAncestor(v, pairs[2][0], pairs[2][1]), ancestors[2]);
+
+        // Common ancestor of a set of nodes
+        std::vector<unsigned int> nodes = {pairs[2][0], pairs[3][0], pairs[3][1], pairs[4][0]};
+        EXPECT_EQ(index.lca(nodes),
+                  naiveLCA(naiveLCA(nodes[0], nodes[1]), naiveLCA(nodes[2], nodes[3])));
+        EXPECT_EQ(index.lca({nodes[0]}), nodes[0]);
+        EXPECT_THROW(index.lca(std::vector<unsigned int>{}), std::invalid_argument);
+
+        // Paths to the root
+        std::vector<std::vector<unsigned int>> paths = getAncestryPaths(v);
+        ASSERT_EQ(paths.size(), numNodes - 1);
+        for (unsigned int node = 0; node + 1 < numNodes; ++node) {
+            ASSERT_EQ(paths[node].size(), depth[node] + 1);
+            ASSERT_EQ(paths[node].front(), node);
+            for (size_t i = 1; i < paths[node].size(); ++i) {
+                ASSERT_EQ(paths[node][i], parent[paths[node][i - 1]]);
+            }
+        }
+
+        // The leaves in the range of a node are exactly its descendants
+        const std::vector<unsigned int> &leafOrder = index.getLeafOrder();
+        ASSERT_EQ(leafOrder.size(), numLeaves);
+        for (size_t i = 0; i < 20; ++i) {
+            unsigned int node = nodeDistr(gen);
+            auto [begin, end] = index.getLeafRange(node);
+            std::vector<bool> inRange(numLeaves, false);
+            for (unsigned int j = begin; j < end; ++j) {
+                inRange[leafOrder[j]] = true;
+            }
+            for (int leaf = 0; leaf < numLeaves; ++leaf) {
+                ASSERT_EQ(inRange[leaf], naiveLCA(leaf, node) == node);
+            }
+        }
+
+        // Leaf distances match the cophenetic distances
+        for (bool unrooted : {false, true}) {
+            Matrix D = copheneticDistances(v, unrooted);
+            for (size_t i = 0; i < 100; ++i) {
+                unsigned int a = nodeDistr(gen) % numLeaves, b = nodeDistr(gen) % numLeaves;
+                EXPECT_EQ(index.distance(a, b, unrooted), D[a][b]);
+            }
+        }
+
+        EXPECT_THROW(index.lca(0, numNodes), std::out_of_range);
+    }
+}
+
+TEST(UtilsTest, ThreadPoolTest) {
+    ThreadPool pool(4);
+    EXPECT_EQ(pool.size(), 4);
+
+    // Many short loops on the same workers: each index is visited exactly once
+    std::vector<std::atomic<unsigned int>> visits(100);
+    for (size_t _ = 0; _ < 1000; ++_) {
+        pool.parallelFor(visits.size(), [&](size_t i, unsigned int thread) {
+            ASSERT_LT(thread, pool.size());
+            ++visits[i];
+        });
+    }
+    for (const auto &count : visits) {
+        EXPECT_EQ(count, 1000);
+    }
+
+    // Exceptions reach the caller, and the pool is still usable
+    EXPECT_THROW(pool.parallelFor(100,
+                                  [](size_t i, unsigned int) {
+                                      if (i == 42) {
+                                          throw std::runtime_error("fail");
+                                      }
+                                  }),
+                 std::runtime_error);
+    size_t total = 0;
+    pool.parallelFor(1, [&](size_t i, unsigned int) { total += i + 1; });
+    EXPECT_EQ(total, 1);
+
+    // A grain size of 0 is taken as 1
+    std::vector<std::atomic<unsigned int>> grainVisits(10);
+    pool.parallelFor(grainVisits.size(), [&](size_t i, unsigned int) { ++grainVisits[i]; }, 0);
+    parallelFor(grainVisits.size(), 4, [&](size_t i, unsigned int) { ++grainVisits[i]; }, 0);
+    for (const auto &count : grainVisits) {
+        EXPECT_EQ(count, 2);
+    }
+}
+
+TEST(UtilsTest, TreeLossesTest) {
+    std::mt19937 gen(42);
+
+    // BME: naive sum over pairs of leaves, with shuffled taxa
+    const size_t numTaxa = 50;
+    std::vector<double> distances(numTaxa * numTaxa);
+    std::uniform_real_distribution<double> distanceDistr(0, 1);
+    for (size_t i = 0; i < numTaxa; ++i) {
+        for (size_t j = i + 1; j < numTaxa; ++j) {
+            distances[i * numTaxa + j] = distances[j * numTaxa + i] = distanceDistr(gen);
+        }
+    }
+    TreeLoss bme = makeBMELoss(distances, numTaxa);
+
+    PhyloVec v = sample(numTaxa, false, 42);
+    std::vector<unsigned int> taxa(numTaxa);
+    std::iota(taxa.begin(), taxa.end(), 0);
+    std::shuffle(taxa.begin(), taxa.end(), gen);
+
+    Matrix D = copheneticDistances(v, true);
+    double expected = 0;
+    for (size_t i = 0; i < numTaxa; ++i) {
+        for (size_t j = i + 1; j < numTaxa; ++j) {
+            expected += distances[taxa[i] * numTaxa + taxa[j]] * std::pow(2.0, -D[i][j]);
+        }
+    }
+    EXPECT_NEAR(bme(getPairs(v), taxa), expected, 1e-9);
+
+    // Both losses ignore the root
+    std::vector<std::string> sequences(numTaxa);
+    for (auto &sequence : sequences) {
+        for (size_t s = 0; s < 100; ++s) {
+            sequence += "ACGT-"[gen() % 5];
+        }
+    }
+    TreeLoss parsimony = makeParsimonyLoss(sequences);
+    CounterRNG rng(42);
+    for (size_t _ = 0; _ < N_REPEATS; ++_) {
+        PhyloVec rerooted = v;
+        rerootAtRandom(rerooted, rng);
+        EXPECT_NEAR(bme(getPairs(rerooted), taxa), bme(getPairs(v), taxa), 1e-9);
+        EXPECT_EQ(parsimony(getPairs(rerooted), taxa), parsimony(getPairs(v), taxa));
+    }
+
+    // Parsimony on ((0,1),(2,3)) and ((0,2),(1,3))
+    TreeLoss small = makeParsimonyLoss({"AAc", "AaG", "CCc", "cYa"});
+    std::vector<unsigned int> identity = {0, 1, 2, 3};
+    EXPECT_EQ(small(getPairs(toVectorNoParents("((0,1),(2,3));")), identity), 4);
+    EXPECT_EQ(small(getPairs(toVectorNoParents("((0,2),(1,3));")), identity), 6);
+
+    EXPECT_THROW(makeBMELoss(distances, numTaxa + 1), std::invalid_argument);
+    EXPECT_THROW(makeParsimonyLoss({"ACGT", "ACG"}), std::invalid_argument);
+    EXPECT_THROW(bme(getPairs(PhyloVec{0}), {0, 1}), std::invalid_argument);
+}
+
+TEST(UtilsTest, HillClimbingTest) {
+    // Distances of a random tree: BME should move towards it
+    const size_t numTaxa = 30;
+    PhyloVec target = sample(numTaxa, false, 7);
+    Matrix D = copheneticDistances(target, true);
+    std::vector<double> distances;
+    for (const auto &row : D) {
+        distances.insert(distances.end(), row.begin(), row.end());
+    }
+    TreeLoss loss = makeBMELoss(distances, numTaxa);
+
+    PhyloVec v = sample(numTaxa, false, 42);
+
+    HillClimbingOptions options;
+    options.seed = 3;
+    options.numThreads = 1;
+    size_t numCalls = 0;
+    HillClimbingResult result =
+        hillClimbing(v, loss, options, [&](const HillClimbingProgress &progress) {
+            EXPECT_GE(progress.index, 1);
+            ++numCalls;
+        });
+
+    ASSERT_GE(result.losses.size(), 1 + options.patience);
+    for (size_t i = 1; i < result.losses.size(); ++i) {
+        EXPECT_LE(result.losses[i], result.losses[i - 1] + 1e-9);
+    }
+    EXPECT_LT(result.losses.back(), result.losses.front());
+    EXPECT_NEAR(loss(getPairs(result.v), result.taxa), result.losses.back(), 1e-9);
+    EXPECT_EQ(numCalls, (result.losses.size() - 1) * (numTaxa - 2));
+    EXPECT_NO_THROW(check_v(result.v));
+
+    std::vector<unsigned int> sortedTaxa = result.taxa;
+    std::sort(sortedTaxa.begin(), sortedTaxa.end());
+    for (size_t i = 0; i < numTaxa; ++i) {
+        EXPECT_EQ(sortedTaxa[i], i);
+    }
+
+    // Same result with several threads
+    options.numThreads = 4;
+    HillClimbingResult parallel = hillClimbing(v, loss, options);
+    EXPECT_EQ(parallel.v, result.v);
+    EXPECT_EQ(parallel.taxa, result.taxa);
+    EXPECT_EQ(parallel.losses, result.losses);
+
+    options.reorderMethod = "dfs";
+    EXPECT_THROW(hillClimbing(v, loss, options), std::invalid_argument);
+}
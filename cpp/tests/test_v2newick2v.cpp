@@ -1,7 +1,15 @@
 #include <gtest/gtest.h>
 
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+
 #include "../base/to_newick.hpp"
 #include "../base/to_vector.hpp"
+#include "../io/tree_file.hpp"
+#include "../matrix/to_matrix.hpp"
+#include "../matrix/to_newick.hpp"
 #include "../ops/newick.hpp"
 #include "../ops/vector.hpp"
 #include "config.cpp"
@@ -24,6 +32,106 @@ TEST_P(V2Newick2VTest, V2Newick2V) {
     }
 }
 
+TEST_P(V2Newick2VTest, NewickLength) {
+    int numLeaves = GetParam();
+    PhyloVec v = sample(numLeaves, false);
+
+    for (bool withInternals : {true, false}) {
+        std::string newick = toNewick(v, withInternals);
+
+        EXPECT_EQ(newick.size(), getNewickLength(numLeaves, withInternals));
+
+        // Writing into an existing (larger) string gives the same output
+        std::string reused(2 * newick.size(), 'x');
+        toNewick(v, reused, withInternals);
+
+        EXPECT_EQ(newick, reused);
+    }
+}
+
+TEST(V2Newick2VTest, PairsFlatVsTree) {
+    // The parameterised tests stay below SMALL_TREE_LEAVES: check both getPairs paths
+    // against the AVL tree on either side of the threshold
+    for (size_t numLeaves : {size_t(MIN_N_LEAVES), size_t(MAX_N_LEAVES), SMALL_TREE_LEAVES - 1,
+                             SMALL_TREE_LEAVES, SMALL_TREE_LEAVES + 1, 2 * SMALL_TREE_LEAVES}) {
+        AVLTree tree;
+        Pairs flat, pairs;
+        for (bool ordered : {false, true}) {
+            for (std::uint64_t seed = 0; seed < 3; ++seed) {
+                PhyloVec v = sample(numLeaves, ordered, seed);
+                Pairs expected = makeTree(v).getPairs();
+
+                getPairsFlat(v, flat);
+                EXPECT_EQ(flat, expected);
+
+                EXPECT_EQ(getPairs(v), expected);
+                getPairs(v, tree, pairs);
+                EXPECT_EQ(pairs, expected);
+            }
+        }
+    }
+}
+
+TEST(V2Newick2VTest, OutOfRangeLabels) {
+    EXPECT_EQ(toVector("((0,1)3,2)4;"), (PhyloVec{0, 2}));
+    EXPECT_EQ(toVectorNoParents("((0,1),2);"), (PhyloVec{0, 2}));
+
+    // Labels of a tree with 3 leaves are below 5 (below 3 for leaves)
+    EXPECT_THROW(toVector("((0,1)5,2)4;"), std::invalid_argument);
+    EXPECT_THROW(toVector("((0,7)3,2)4;"), std::invalid_argument);
+    EXPECT_THROW(toVectorNoParents("((0,3),2);"), std::invalid_argument);
+    EXPECT_THROW(toVectorNoParentsBatch({"((0,1),2);", "((0,1),9);"}), std::invalid_argument);
+}
+
+TEST_P(V2Newick2VTest, StreamNewick) {
+    int numLeaves = GetParam();
+    PhyloVec v = sample(numLeaves, false);
+    Pairs pairs = getPairs(v);
+
+    for (bool withInternals : {true, false}) {
+        std::string streamed;
+        size_t numChunks = 0;
+        streamNewick(
+            pairs,
+            [&](std::string_view chunk) {
+                streamed += chunk;
+                ++numChunks;
+            },
+            withInternals, 16);
+
+        EXPECT_EQ(streamed, buildNewick(pairs, withInternals));
+        EXPECT_GE(numChunks, streamed.size() / 16);
+
+        std::ostringstream oss;
+        toNewickStream(v, oss, withInternals);
+
+        EXPECT_EQ(oss.str(), streamed);
+    }
+}
+
+TEST_P(V2Newick2VTest, Batch) {
+    int numLeaves = GetParam();
+
+    std::vector<PhyloVec> vs;
+    for (size_t _ = 0; _ < N_REPEATS; ++_) {
+        vs.push_back(sample(numLeaves, false));
+    }
+
+    std::vector<std::string> newicks = toNewickBatch(vs, true, 4);
+    std::vector<std::string> newicksNoParents = toNewickBatch(vs, false, 4);
+
+    std::vector<std::string_view> views(newicks.begin(), newicks.end());
+    std::vector<std::string_view> viewsNoParents(newicksNoParents.begin(),
+                                                 newicksNoParents.end());
+
+    for (size_t i = 0; i < vs.size(); ++i) {
+        EXPECT_EQ(newicks[i], toNewick(vs[i]));
+    }
+
+    EXPECT_EQ(toVectorBatch(views, 4), vs);
+    EXPECT_EQ(toVectorNoParentsBatch(viewsNoParents, 4), vs);
+}
+
 TEST_P(V2Newick2VTest, Cherries) {
     int numLeaves = GetParam();
     PhyloVec v = sample(numLeaves, false);
@@ -41,3 +149,197 @@ TEST_P(V2Newick2VTest, Cherries) {
 
     EXPECT_EQ(anc, ancNoParents);
 }
+
+TEST_P(V2Newick2VTest, Workspace) {
+    int numLeaves = GetParam();
+
+    // A single workspace shared across trees of different sizes
+    ConversionWorkspace ws;
+    std::string newick;
+    PhyloVec v2;
+
+    for (int n : {numLeaves, 2 * numLeaves, numLeaves / 2 + 2}) {
+        PhyloVec v = sample(n, false);
+
+        toNewick(v, newick, ws);
+        EXPECT_EQ(newick, toNewick(v));
+
+        toVector(newick, v2, ws);
+        EXPECT_EQ(v2, v);
+
+        toNewick(v, newick, ws, false);
+        toVectorNoParents(newick, v2, ws);
+        EXPECT_EQ(v2, v);
+    }
+}
+
+// Replace each integer label of a Newick string by f(label)
+template <typename Function>
+std::string relabel(std::string_view newick, Function f) {
+    std::string result;
+    for (size_t i = 0; i < newick.size(); ++i) {
+        if (isdigit(newick[i])) {
+            size_t j = i;
+            while (j < newick.size() && isdigit(newick[j])) {
+                ++j;
+            }
+            result += f(std::stoi(std::string(newick.substr(i, j - i))));
+            i = j - 1;
+        } else {
+            result += newick[i];
+        }
+    }
+    return result;
+}
+
+TEST_P(V2Newick2VTest, TreeFile) {
+    int numLeaves = GetParam();
+
+    std::vector<PhyloVec> vs;
+    for (size_t _ = 0; _ < N_REPEATS; ++_) {
+        vs.push_back(sample(numLeaves, false));
+    }
+
+    std::string path = testing::TempDir() + "phylo2vec_trees_" + std::to_string(numLeaves) + ".nwk";
+
+    for (NewickLabels labels :
+         {NewickLabels::Parents, NewickLabels::NoParents, NewickLabels::Taxa}) {
+        {
+            std::ofstream out(path);
+            for (const auto &v : vs) {
+                std::string newick = toNewick(v, labels == NewickLabels::Parents);
+                if (labels == NewickLabels::Taxa) {
+                    // Taxa with branch lengths
+                    newick = relabel(newick, [](int leaf) {
+                        return "taxon" + std::to_string(leaf) + ":0.5";
+                    });
+                }
+                // Blank lines and Windows line endings are skipped
+                out << newick << "\r\n\n";
+            }
+        }
+
+        MappedFile file(path);
+        VectorCollection collection = readTreeFile(file, labels, 4);
+
+        ASSERT_EQ(collection.offsets.size(), vs.size() + 1);
+        for (size_t i = 0; i < vs.size(); ++i) {
+            PhyloVec v(collection.data.begin() + collection.offsets[i],
+                       collection.data.begin() + collection.offsets[i + 1]);
+
+            if (labels == NewickLabels::Taxa) {
+                // Leaves are numbered by order of appearance:
+                // map them back to the original labels
+                const Leaf2Taxon &taxa = collection.taxa[i];
+                ASSERT_EQ(taxa.size(), v.size() + 1);
+                std::string newick = relabel(toNewick(v, false), [&taxa](int leaf) {
+                    return std::string(taxa[leaf].substr(5));
+                });
+                v = toVectorNoParents(newick);
+            }
+
+            EXPECT_EQ(v, vs[i]);
+        }
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST_P(V2Newick2VTest, Matrix) {
+    int numLeaves = GetParam();
+
+    std::mt19937 rng(numLeaves);
+    std::uniform_real_distribution<float> dist(0.0f, 4.0f);
+
+    ConversionWorkspace ws;
+    PhyloMat m2;
+
+    for (size_t _ = 0; _ < N_REPEATS; ++_) {
+        PhyloMat m;
+        m.v = sample(numLeaves, false);
+        for (size_t i = 0; i < m.v.size(); ++i) {
+            m.branches.push_back({dist(rng), dist(rng)});
+        }
+
+        // Shortest round-trip formatting: branch lengths are recovered exactly
+        std::string newick = toNewick(m);
+        EXPECT_LE(newick.size(), getMaxNewickWithBranchesLength(numLeaves));
+
+        toMatrix(newick, m2, ws);
+        EXPECT_EQ(m2.v, m.v);
+        EXPECT_EQ(m2.branches, m.branches);
+
+        // Remove the parent labels but keep the branch lengths
+        std::string newickNoParents;
+        for (size_t i = 0; i < newick.size(); ++i) {
+            newickNoParents += newick[i];
+            if (newick[i] == ')') {
+                while (i + 1 < newick.size() && isdigit(newick[i + 1])) {
+                    ++i;
+                }
+            }
+        }
+
+        PhyloMat m3 = toMatrixNoParents(newickNoParents);
+        EXPECT_EQ(m3.v, m.v);
+        EXPECT_EQ(m3.branches, m.branches);
+
+        // Fixed precision
+        std::string newickFixed = toNewick(m, 3);
+        EXPECT_LE(newickFixed.size(), getMaxNewickWithBranchesLength(numLeaves, 3));
+
+        PhyloMat m4 = toMatrix(newickFixed);
+        EXPECT_EQ(m4.v, m.v);
+        for (size_t i = 0; i < m.branches.size(); ++i) {
+            for (size_t j = 0; j < 2; ++j) {
+                EXPECT_NEAR(m4.branches[i][j], m.branches[i][j], 1e-3);
+            }
+        }
+    }
+}
+
+TEST_P(V2Newick2VTest, MatrixPrecision) {
+    int numLeaves = GetParam();
+
+    std::mt19937 rng(numLeaves);
+    std::uniform_real_distribution<double> dist(0.0, 4.0);
+
+    BasicPhyloMat<double> m;
+    m.v = sample(numLeaves, false);
+    for (size_t i = 0; i < m.v.size(); ++i) {
+        m.branches.push_back({dist(rng), dist(rng)});
+    }
+
+    // Double precision round trip
+    std::string newick = toNewick(m);
+    BasicPhyloMat<double> mDouble = toMatrix<double>(newick);
+    EXPECT_EQ(mDouble.v, m.v);
+    EXPECT_EQ(mDouble.branches, m.branches);
+
+    // SoA layout
+    auto mSoA = toMatrix<double, BranchLayout::SoA>(newick);
+    EXPECT_EQ(mSoA.v, m.v);
+    EXPECT_EQ(mSoA.branches, (convertMatrix<double, BranchLayout::SoA>(m).branches));
+    EXPECT_EQ(toNewick(mSoA), newick);
+
+    // Explicit conversions
+    PhyloMat mFloat = convertMatrix<float>(m);
+    EXPECT_EQ(convertMatrix<float>(convertMatrix<double>(mFloat)).branches, mFloat.branches);
+    EXPECT_EQ(toMatrix(toNewick(mFloat)).branches, mFloat.branches);
+
+    // Half-precision storage round trip
+    BasicPhyloMat<Half> mHalf = convertMatrix<Half>(m);
+    EXPECT_EQ(toMatrix<Half>(toNewick(mHalf)).branches, mHalf.branches);
+
+    auto mHalfSoA = toMatrix<Half, BranchLayout::SoA>(
+        toNewick(convertMatrix<Half, BranchLayout::SoA>(mHalf)));
+    EXPECT_EQ(mHalfSoA.v, m.v);
+    for (size_t i = 0; i < m.branches.size(); ++i) {
+        EXPECT_NEAR(float(mHalfSoA.branches.left[i]), m.branches[i][0], 2e-3);
+        EXPECT_NEAR(float(mHalfSoA.branches.right[i]), m.branches[i][1], 2e-3);
+    }
+
+    // One row of branch lengths per cherry
+    m.branches.pop_back();
+    EXPECT_THROW(toNewick(m), std::invalid_argument);
+}
@@ -1,82 +1,101 @@
 #include "avl.hpp"
 
 #include <algorithm>
-#include <stack>
 
-AVLTree::AVLTree() { root = nullptr; }
+// nodes[0] is the sentinel: an empty subtree of height 0 and size 0
+AVLTree::AVLTree() : nodes(1), root(0) {}
 
-Node *AVLTree::getRoot() { return root; }
+unsigned int AVLTree::getRoot() { return root; }
 
-Pairs AVLTree::getPairs() { return inorderTraversal(root); }
-
-Pairs AVLTree::inorderTraversal(Node *node) {
+Pairs AVLTree::getPairs() {
     Pairs result;
-    std::stack<Node *> stack;
-    Node *current = node;
+    inorderTraversal(root, result);
+    return result;
+}
+
+void AVLTree::getPairs(Pairs &pairs) { inorderTraversal(root, pairs); }
+
+void AVLTree::clear() {
+    nodes.resize(1);
+    root = 0;
+}
+
+void AVLTree::reserve(size_t n) { nodes.reserve(n + 1); }
 
-    while (current != nullptr || !stack.empty()) {
-        while (current != nullptr) {
-            stack.push(current);
-            current = current->left;
+void AVLTree::inorderTraversal(unsigned int node, Pairs &result) {
+    result.clear();
+    result.reserve(nodes.size() - 1);
+    stack.clear();
+
+    unsigned int current = node;
+
+    while (current != 0 || !stack.empty()) {
+        while (current != 0) {
+            stack.push_back(current);
+            current = nodes[current].left;
         }
 
-        current = stack.top();
-        stack.pop();
-        result.push_back(current->value);
+        current = stack.back();
+        stack.pop_back();
+        result.push_back(nodes[current].value);
 
-        current = current->right;
+        current = nodes[current].right;
     }
-
-    return result;
 }
 
 void AVLTree::insert(int index, Pair value) {
     this->root = insertByIndex(this->root, index, value);
 }
 
-Node *AVLTree::insertByIndex(Node *node, int index, Pair value) {
-    if (!node) {
-        return new Node(value);
+unsigned int AVLTree::insertByIndex(unsigned int node, int index, Pair value) {
+    if (node == 0) {
+        nodes.emplace_back(value);
+        return nodes.size() - 1;
     }
 
-    int left_size = getSizeOfNode(node->left);
+    int left_size = getSizeOfNode(nodes[node].left);
 
+    // Note: nodes may be reallocated by the recursive call,
+    // so the child index is stored before re-indexing the pool
     if (index <= left_size) {  // Insert in the left subtree
-        node->left = insertByIndex(node->left, index, value);
+        unsigned int left = insertByIndex(nodes[node].left, index, value);
+        nodes[node].left = left;
     } else {  // Insert in the right subtree
-        node->right = insertByIndex(node->right, index - left_size - 1, value);
+        unsigned int right = insertByIndex(nodes[node].right, index - left_size - 1, value);
+        nodes[node].right = right;
     }
 
     update(node);
     return balance(node);
 }
 
-void AVLTree::update(Node *node) {
-    if (node) {
-        node->height = 1 + std::max(getHeightofNode(node->left), getHeightofNode(node->right));
-        node->size = 1 + getSizeOfNode(node->left) + getSizeOfNode(node->right);
+void AVLTree::update(unsigned int node) {
+    if (node != 0) {
+        Node &n = nodes[node];
+        n.height = 1 + std::max(getHeightofNode(n.left), getHeightofNode(n.right));
+        n.size = 1 + getSizeOfNode(n.left) + getSizeOfNode(n.right);
     }
 }
 
-Node *AVLTree::balance(Node *node) {
+unsigned int AVLTree::balance(unsigned int node) {
     int balance = getBalanceOfNode(node);
 
     // Left Left Case
     if (balance > 1) {
-        if (getBalanceOfNode(node->left) >= 0) {
+        if (getBalanceOfNode(nodes[node].left) >= 0) {
             return rightRotate(node);
         } else {  // Left Right Case
-            node->left = leftRotate(node->left);
+            nodes[node].left = leftRotate(nodes[node].left);
             return rightRotate(node);
         }
     }
 
     // Right Right Case
     if (balance < -1) {
-        if (getBalanceOfNode(node->right) <= 0) {
+        if (getBalanceOfNode(nodes[node].right) <= 0) {
             return leftRotate(node);
         } else {  // Right Left Case
-            node->right = rightRotate(node->right);
+            nodes[node].right = rightRotate(nodes[node].right);
             return leftRotate(node);
         }
     }
@@ -84,46 +103,47 @@ Node *AVLTree::balance(Node *node) {
     return node;
 }
 
-Node *AVLTree::leftRotate(Node *x) {
-    Node *y = x->right;
-    Node *T2 = y->left;
-    y->left = x;
-    x->right = T2;
+unsigned int AVLTree::leftRotate(unsigned int x) {
+    unsigned int y = nodes[x].right;
+    unsigned int T2 = nodes[y].left;
+    nodes[y].left = x;
+    nodes[x].right = T2;
     update(x);
     update(y);
     return y;
 }
 
-Node *AVLTree::rightRotate(Node *y) {
-    Node *x = y->left;
-    Node *T2 = x->right;
-    x->right = y;
-    y->left = T2;
+unsigned int AVLTree::rightRotate(unsigned int y) {
+    unsigned int x = nodes[y].left;
+    unsigned int T2 = nodes[x].right;
+    nodes[x].right = y;
+    nodes[y].left = T2;
     update(y);
     update(x);
     return x;
 }
 
-Pair AVLTree::lookup(Node *node, int index) {
-    if (!node) {
-        return {0, 0};  // Index out of bounds
+Pair AVLTree::lookup(unsigned int node, int index) {
+    while (node != 0) {
+        int left_size = getSizeOfNode(nodes[node].left);
+
+        if (index < left_size) {  // Search in left subtree
+            node = nodes[node].left;
+        } else if (index == left_size) {  // Found the node
+            return nodes[node].value;
+        } else {  // Search in right subtree
+            index -= left_size + 1;
+            node = nodes[node].right;
+        }
     }
 
-    int left_size = getSizeOfNode(node->left);
-
-    if (index < left_size) {  // Search in left subtree
-        return lookup(node->left, index);
-    } else if (index == left_size) {  // Found the node
-        return node->value;
-    } else {  // Search in right subtree
-        return lookup(node->right, index - left_size - 1);
-    }
+    return {0, 0};  // Index out of bounds
 }
 
-int AVLTree::getBalanceOfNode(Node *node) {
-    return node ? getHeightofNode(node->left) - getHeightofNode(node->right) : 0;
+int AVLTree::getBalanceOfNode(unsigned int node) {
+    return node != 0 ? getHeightofNode(nodes[node].left) - getHeightofNode(nodes[node].right) : 0;
 }
 
-unsigned int AVLTree::getHeightofNode(Node *node) { return node ? node->height : 0; }
+unsigned int AVLTree::getHeightofNode(unsigned int node) { return nodes[node].height; }
 
-unsigned int AVLTree::getSizeOfNode(Node *node) { return node ? node->size : 0; }
+unsigned int AVLTree::getSizeOfNode(unsigned int node) { return nodes[node].size; }
@@ -3,48 +3,78 @@
 
 #include "../base/core.hpp"
 
+/**
+ * @brief Node of an AVLTree
+ * Nodes live in a contiguous pool owned by the tree
+ * and refer to their children by 32-bit indices.
+ * Index 0 is a sentinel (empty subtree).
+ */
 struct Node {
     Pair value;
-    Node *left;
-    Node *right;
+    unsigned int left;    // Index of the left child in the pool
+    unsigned int right;   // Index of the right child in the pool
     unsigned int height;  // Height of the node
     unsigned int size;    // Number of nodes in the subtree
 
-    Node(Pair val) : value(val), left(nullptr), right(nullptr), height(1), size(1) {}
+    Node() : value({0, 0}), left(0), right(0), height(0), size(0) {}
+
+    Node(Pair val) : value(val), left(0), right(0), height(1), size(1) {}
 };
 
 class AVLTree {
    public:
     AVLTree();
 
-    Node *getRoot();
+    unsigned int getRoot();
 
     Pairs getPairs();
 
+    /**
+     * @brief In-order traversal of the tree into a caller-provided buffer
+     * (the buffer is overwritten)
+     */
+    void getPairs(Pairs &pairs);
+
     void insert(int index, Pair value);
 
-    Pair lookup(Node *node, int index);
+    Pair lookup(unsigned int node, int index);
+
+    /**
+     * @brief Remove all nodes while keeping the pool allocated,
+     * so that the tree can be rebuilt without new allocations
+     */
+    void clear();
+
+    /**
+     * @brief Reserve room for n nodes in the pool
+     */
+    void reserve(size_t n);
 
    private:
-    Node *root;
+    std::vector<Node> nodes;
+
+    unsigned int root;
+
+    // Scratch stack for the in-order traversal
+    std::vector<unsigned int> stack;
 
-    int getBalanceOfNode(Node *node);
+    int getBalanceOfNode(unsigned int node);
 
-    unsigned int getHeightofNode(Node *node);
+    unsigned int getHeightofNode(unsigned int node);
 
-    unsigned int getSizeOfNode(Node *node);
+    unsigned int getSizeOfNode(unsigned int node);
 
-    void update(Node *node);
+    void update(unsigned int node);
 
-    Node *leftRotate(Node *x);
+    unsigned int leftRotate(unsigned int x);
 
-    Node *rightRotate(Node *y);
+    unsigned int rightRotate(unsigned int y);
 
-    Node *balance(Node *node);
+    unsigned int balance(unsigned int node);
 
-    Node *insertByIndex(Node *node, int index, Pair value);
+    unsigned int insertByIndex(unsigned int node, int index, Pair value);
 
-    Pairs inorderTraversal(Node *node);
+    void inorderTraversal(unsigned int node, Pairs &result);
 };
 
-#endif  // AVL_HPP
\ No newline at end of file
+#endif  // AVL_HPP
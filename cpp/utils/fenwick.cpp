@@ -16,4 +16,9 @@ void FenwickTree::update(unsigned int i, unsigned int delta) {
         data[i] += delta;
         i += i & -i;
     }
-}
\ No newline at end of file
+}
+
+void FenwickTree::reset(unsigned int n) {
+    n_leaves = n;
+    data.assign(n + 1, 0);
+}
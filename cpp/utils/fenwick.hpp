@@ -5,14 +5,19 @@
 
 class FenwickTree {
    public:
-    FenwickTree(unsigned int n);
+    FenwickTree(unsigned int n = 0);
 
     unsigned int prefix_sum(unsigned int i);
     void update(unsigned int i, unsigned int delta);
 
+    /**
+     * @brief Reset to n zeros, reusing the current storage
+     */
+    void reset(unsigned int n);
+
    private:
     unsigned int n_leaves;
     std::vector<unsigned int> data;
 };
 
-#endif  // FENWICK_HPP
\ No newline at end of file
+#endif  // FENWICK_HPP
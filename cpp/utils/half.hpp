@@ -0,0 +1,94 @@
+#ifndef HALF_HPP
+#define HALF_HPP
+
+/**
+ * @file half.hpp
+ * @brief IEEE 754 half-precision (binary16) storage type
+ */
+
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief Half-precision float, meant for compact storage only
+ * Values are converted explicitly from/to float (round to nearest even),
+ * arithmetic should be done in float.
+ */
+struct Half {
+    uint16_t bits;
+
+    Half() : bits(0) {}
+
+    explicit Half(float value) : bits(fromFloat(value)) {}
+
+    explicit operator float() const { return toFloat(bits); }
+
+    bool operator==(const Half &other) const { return bits == other.bits; }
+
+    bool operator!=(const Half &other) const { return bits != other.bits; }
+
+    static uint16_t fromFloat(float value) {
+        uint32_t x;
+        std::memcpy(&x, &value, sizeof(x));
+
+        const uint32_t sign = x & 0x80000000u;
+        x ^= sign;
+
+        uint16_t result;
+        if (x >= 0x47800000u) {
+            // Too large for a half (>= 2^16), infinity or NaN
+            result = x > 0x7f800000u ? 0x7e00 : 0x7c00;
+        } else if (x < 0x38800000u) {
+            // Subnormal half or zero (< 2^-14): let the FPU round the mantissa
+            // by adding a magic number which aligns it to the last bits
+            const uint32_t magicBits = 0x3f000000u;
+            float f, magic;
+            std::memcpy(&f, &x, sizeof(f));
+            std::memcpy(&magic, &magicBits, sizeof(magic));
+            f += magic;
+            uint32_t y;
+            std::memcpy(&y, &f, sizeof(y));
+            result = y - magicBits;
+        } else {
+            // Normal half: rebias the exponent and round the mantissa to nearest even
+            const uint32_t mantissaOdd = (x >> 13) & 1;
+            x += 0xc8000fffu + mantissaOdd;
+            result = x >> 13;
+        }
+
+        return result | (sign >> 16);
+    }
+
+    static float toFloat(uint16_t h) {
+        const uint32_t shiftedExponent = 0x7c00u << 13;
+
+        uint32_t x = (h & 0x7fffu) << 13;
+        const uint32_t exponent = shiftedExponent & x;
+        // Rebias the exponent
+        x += (127 - 15) << 23;
+
+        float result;
+        if (exponent == shiftedExponent) {
+            // Infinity or NaN
+            x += (128 - 16) << 23;
+            std::memcpy(&result, &x, sizeof(result));
+        } else if (exponent == 0) {
+            // Zero or subnormal: renormalise with a float subtraction
+            x += 1 << 23;
+            const uint32_t magicBits = 113u << 23;
+            float magic;
+            std::memcpy(&result, &x, sizeof(result));
+            std::memcpy(&magic, &magicBits, sizeof(magic));
+            result -= magic;
+        } else {
+            std::memcpy(&result, &x, sizeof(result));
+        }
+
+        if (h & 0x8000u) {
+            result = -result;
+        }
+        return result;
+    }
+};
+
+#endif  // HALF_HPP
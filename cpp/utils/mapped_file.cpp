@@ -0,0 +1,152 @@
+#include "mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+MappedFile::MappedFile(const std::string &path) : ptr(nullptr), length(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::system_error(errno, std::generic_category(), "Cannot open " + path);
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == -1) {
+        int error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(), "Cannot stat " + path);
+    }
+
+    length = info.st_size;
+
+    // mmap does not accept empty mappings
+    if (length > 0) {
+        void *mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            int error = errno;
+            close(fd);
+            throw std::system_error(error, std::generic_category(), "Cannot map " + path);
+        }
+        ptr = static_cast<const char *>(mapping);
+    }
+
+    // The mapping keeps its own reference to the file
+    close(fd);
+}
+
+MappedFile::~MappedFile() { unmap(); }
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : ptr(std::exchange(other.ptr, nullptr)), length(std::exchange(other.length, 0)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        unmap();
+        ptr = std::exchange(other.ptr, nullptr);
+        length = std::exchange(other.length, 0);
+    }
+    return *this;
+}
+
+void MappedFile::unmap() {
+    if (ptr != nullptr) {
+        munmap(const_cast<char *>(ptr), length);
+        ptr = nullptr;
+        length = 0;
+    }
+}
+
+MappedOutputFile::MappedOutputFile(const std::string &path, size_t size)
+    : ptr(nullptr), length(size), fd(-1) {
+    fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        throw std::system_error(errno, std::generic_category(), "Cannot create " + path);
+    }
+
+    if (ftruncate(fd, length) == -1) {
+        int error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(), "Cannot resize " + path);
+    }
+
+    if (length > 0) {
+        void *mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED) {
+            int error = errno;
+            close(fd);
+            throw std::system_error(error, std::generic_category(), "Cannot map " + path);
+        }
+        ptr = static_cast<char *>(mapping);
+    }
+}
+
+MappedOutputFile::~MappedOutputFile() { unmap(); }
+
+MappedOutputFile::MappedOutputFile(MappedOutputFile &&other) noexcept
+    : ptr(std::exchange(other.ptr, nullptr)),
+      length(std::exchange(other.length, 0)),
+      fd(std::exchange(other.fd, -1)) {}
+
+MappedOutputFile &MappedOutputFile::operator=(MappedOutputFile &&other) noexcept {
+    if (this != &other) {
+        unmap();
+        ptr = std::exchange(other.ptr, nullptr);
+        length = std::exchange(other.length, 0);
+        fd = std::exchange(other.fd, -1);
+    }
+    return *this;
+}
+
+void MappedOutputFile::startWriteBack(size_t offset, size_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    const size_t pageSize = sysconf(_SC_PAGESIZE);
+    const size_t start = offset / pageSize * pageSize;
+    const size_t end = std::min(offset + count, length);
+
+#ifdef __linux__
+    // Queue the dirty pages of the range for writing, without waiting for the disk
+    if (sync_file_range(fd, start, end - start, SYNC_FILE_RANGE_WRITE) == -1) {
+#else
+    if (msync(ptr + start, end - start, MS_ASYNC) == -1) {
+#endif
+        throw std::system_error(errno, std::generic_category(), "Cannot write back mapping");
+    }
+}
+
+void MappedOutputFile::flush(size_t offset, size_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    // msync and madvise work on whole pages
+    const size_t pageSize = sysconf(_SC_PAGESIZE);
+    const size_t start = offset / pageSize * pageSize;
+    const size_t end = std::min(offset + count, length);
+
+    if (msync(ptr + start, end - start, MS_SYNC) == -1) {
+        throw std::system_error(errno, std::generic_category(), "Cannot write back mapping");
+    }
+    // The pages of a shared file mapping are reloaded from the file if accessed again
+    madvise(ptr + start, end - start, MADV_DONTNEED);
+}
+
+void MappedOutputFile::unmap() {
+    if (ptr != nullptr) {
+        munmap(ptr, length);
+        ptr = nullptr;
+        length = 0;
+    }
+    if (fd != -1) {
+        close(fd);
+        fd = -1;
+    }
+}
@@ -0,0 +1,109 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+/**
+ * @file mapped_file.hpp
+ * @brief Memory mappings of files (POSIX)
+ */
+
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Read-only memory mapping of a whole file
+ * The mapping is released when the object is destroyed.
+ * Views into the mapping stay valid as long as the object is alive
+ * (including after a move).
+ */
+class MappedFile {
+   public:
+    /**
+     * @brief Map a file into memory
+     * @param path path to the file
+     * @throws std::system_error if the file cannot be opened or mapped
+     */
+    explicit MappedFile(const std::string &path);
+
+    ~MappedFile();
+
+    MappedFile(MappedFile &&other) noexcept;
+
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *data() const { return ptr; }
+
+    size_t size() const { return length; }
+
+    std::string_view view() const { return {ptr, length}; }
+
+   private:
+    const char *ptr;
+
+    size_t length;
+
+    void unmap();
+};
+
+/**
+ * @brief Writable shared memory mapping of a new file of a fixed size
+ * The file is created (or truncated) and extended to its final size, without allocating
+ * disk blocks upfront. Writes to data() reach the file through the page cache.
+ * flush() writes back a range and releases its pages,
+ * so that files larger than RAM can be written sequentially.
+ * startWriteBack() starts writing a range back without waiting,
+ * so that the next range can be filled while the disk is busy.
+ */
+class MappedOutputFile {
+   public:
+    /**
+     * @brief Create a file of a given size and map it into memory
+     * @param path path to the file
+     * @param size size of the file in bytes
+     * @throws std::system_error if the file cannot be created, resized or mapped
+     */
+    MappedOutputFile(const std::string &path, size_t size);
+
+    ~MappedOutputFile();
+
+    MappedOutputFile(MappedOutputFile &&other) noexcept;
+
+    MappedOutputFile &operator=(MappedOutputFile &&other) noexcept;
+
+    MappedOutputFile(const MappedOutputFile &) = delete;
+
+    MappedOutputFile &operator=(const MappedOutputFile &) = delete;
+
+    char *data() { return ptr; }
+
+    size_t size() const { return length; }
+
+    /**
+     * @brief Start writing back the bytes [offset, offset + count) to the file, without waiting
+     * (sync_file_range on Linux, msync(MS_ASYNC) elsewhere)
+     * @throws std::system_error if the write-back cannot be started
+     */
+    void startWriteBack(size_t offset, size_t count);
+
+    /**
+     * @brief Write back the bytes [offset, offset + count) to the file
+     * (waiting for a write-back started by startWriteBack) and release the pages mapping them
+     * @throws std::system_error if the write-back fails
+     */
+    void flush(size_t offset, size_t count);
+
+   private:
+    char *ptr;
+
+    size_t length;
+
+    // Kept open for sync_file_range
+    int fd;
+
+    void unmap();
+};
+
+#endif  // MAPPED_FILE_HPP
@@ -0,0 +1,67 @@
+#include "parallel.hpp"
+
+unsigned int getNumThreads(unsigned int numThreads) {
+    if (numThreads == 0) {
+        numThreads = std::thread::hardware_concurrency();
+    }
+    return std::max(numThreads, 1u);
+}
+
+ThreadPool::ThreadPool(unsigned int numThreads)
+    : task(nullptr), generation(0), numRunning(0), stopping(false) {
+    numThreads = getNumThreads(numThreads);
+    workers.reserve(numThreads - 1);
+    for (unsigned int t = 1; t < numThreads; ++t) {
+        workers.emplace_back(&ThreadPool::work, this, t);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    started.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::run(const std::function<void(unsigned int)> &fn) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = &fn;
+        numRunning = workers.size();
+        ++generation;
+    }
+    started.notify_all();
+
+    fn(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this]() { return numRunning == 0; });
+    task = nullptr;
+}
+
+void ThreadPool::work(unsigned int threadId) {
+    size_t seen = 0;
+    while (true) {
+        const std::function<void(unsigned int)> *current;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            started.wait(lock, [&]() { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            current = task;
+        }
+
+        (*current)(threadId);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--numRunning == 0) {
+            finished.notify_one();
+        }
+    }
+}
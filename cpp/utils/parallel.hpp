@@ -0,0 +1,166 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+/**
+ * @file parallel.hpp
+ * @brief Minimal thread-parallel loops used by the batch APIs
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Resolve a requested number of threads
+ * @param numThreads requested number of threads (0 = all hardware threads)
+ * @return unsigned int number of threads to use (>= 1)
+ */
+unsigned int getNumThreads(unsigned int numThreads);
+
+// Indices of a parallel loop handed out dynamically to the threads running it,
+// with the first exception thrown by fn kept for the calling thread
+template <typename Function>
+class ParallelLoop {
+   public:
+    ParallelLoop(size_t count, Function &fn, size_t grainSize)
+        : count(count), grainSize(std::max<size_t>(grainSize, 1)), fn(fn), next(0) {}
+
+    // Work until all indices are taken (run by each thread)
+    void operator()(unsigned int threadId) {
+        try {
+            size_t start;
+            while ((start = next.fetch_add(grainSize)) < count) {
+                size_t end = std::min(start + grainSize, count);
+                for (size_t i = start; i < end; ++i) {
+                    fn(i, threadId);
+                }
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            // Stop the other workers
+            next = count;
+        }
+    }
+
+    void rethrow() {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+   private:
+    const size_t count;
+    const size_t grainSize;
+    Function &fn;
+    std::atomic<size_t> next;
+    std::exception_ptr error;
+    std::mutex errorMutex;
+};
+
+/**
+ * @brief Run fn(i, threadId) for all i in [0, count) on numThreads threads
+ * Indices are handed out dynamically in blocks of grainSize,
+ * so that uneven work (e.g., trees of different sizes) is balanced.
+ * threadId is in [0, numThreads) and can be used to index per-thread scratch space.
+ * The first exception thrown by fn is rethrown in the calling thread.
+ * @param count number of iterations
+ * @param numThreads number of threads (0 = all hardware threads)
+ * @param fn callable with signature void(size_t i, unsigned int threadId)
+ * @param grainSize number of consecutive iterations taken by a thread at once (0 is taken as 1)
+ */
+template <typename Function>
+void parallelFor(size_t count, unsigned int numThreads, Function fn, size_t grainSize = 1) {
+    grainSize = std::max<size_t>(grainSize, 1);
+    numThreads = std::min<size_t>(getNumThreads(numThreads),
+                                  std::max<size_t>((count + grainSize - 1) / grainSize, 1));
+
+    if (numThreads == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            fn(i, 0);
+        }
+        return;
+    }
+
+    ParallelLoop<Function> loop(count, fn, grainSize);
+
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads - 1);
+    for (unsigned int t = 1; t < numThreads; ++t) {
+        threads.emplace_back([&loop, t]() { loop(t); });
+    }
+    loop(0);
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    loop.rethrow();
+}
+
+/**
+ * @brief Threads kept alive across parallel loops
+ * parallelFor spawns and joins its threads on each call, which costs tens of microseconds:
+ * loops run many times on little work each (e.g., once per entry of a vector) reuse a pool.
+ * The calling thread works as thread 0, and one loop runs at a time.
+ */
+class ThreadPool {
+   public:
+    /**
+     * @brief Start the worker threads
+     * @param numThreads number of threads, including the calling thread
+     * (0 = all hardware threads)
+     */
+    explicit ThreadPool(unsigned int numThreads);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    unsigned int size() const { return workers.size() + 1; }
+
+    /**
+     * @brief Run fn(i, threadId) for all i in [0, count) on the threads of the pool
+     * (as the free parallelFor, with threadId in [0, size()))
+     */
+    template <typename Function>
+    void parallelFor(size_t count, Function fn, size_t grainSize = 1) {
+        if (workers.empty() || count <= grainSize) {
+            for (size_t i = 0; i < count; ++i) {
+                fn(i, 0);
+            }
+            return;
+        }
+
+        ParallelLoop<Function> loop(count, fn, grainSize);
+        run([&loop](unsigned int threadId) { loop(threadId); });
+        loop.rethrow();
+    }
+
+   private:
+    // Run fn(threadId) on every thread, and wait for all of them (fn must not throw)
+    void run(const std::function<void(unsigned int)> &fn);
+
+    void work(unsigned int threadId);
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable started;
+    std::condition_variable finished;
+    const std::function<void(unsigned int)> *task;
+    // Number of tasks run so far, and of workers still running the current one
+    size_t generation;
+    unsigned int numRunning;
+    bool stopping;
+};
+
+#endif  // PARALLEL_HPP
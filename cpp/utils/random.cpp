@@ -0,0 +1,36 @@
+#include "random.hpp"
+
+// SplitMix64 finalizer (a bijective 64-bit mixing function)
+static std::uint64_t mix64(std::uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+const std::uint64_t GOLDEN_GAMMA = 0x9e3779b97f4a7c15ULL;
+
+CounterRNG::CounterRNG(std::uint64_t seed, std::uint64_t stream)
+    : key(mix64(mix64(seed) ^ mix64(stream + GOLDEN_GAMMA))), counter(0) {}
+
+CounterRNG::result_type CounterRNG::operator()() {
+    // Two mixing rounds keyed by (seed, stream) over the draw index
+    return mix64(mix64(key + GOLDEN_GAMMA * ++counter) ^ key);
+}
+
+void CounterRNG::discard(std::uint64_t n) { counter += n; }
+
+std::uint32_t CounterRNG::bounded(std::uint32_t range) {
+    std::uint64_t m = (operator()() >> 32) * range;
+    std::uint32_t low = static_cast<std::uint32_t>(m);
+
+    if (low < range) {
+        // Reject the values which would make the lowest outputs over-represented
+        std::uint32_t threshold = -range % range;
+        while (low < threshold) {
+            m = (operator()() >> 32) * range;
+            low = static_cast<std::uint32_t>(m);
+        }
+    }
+
+    return static_cast<std::uint32_t>(m >> 32);
+}
@@ -0,0 +1,49 @@
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+/**
+ * @file random.hpp
+ * @brief Counter-based random number generation
+ */
+
+#include <cstdint>
+
+/**
+ * @brief Counter-based pseudo-random generator
+ * The i-th output of stream s under seed k is a hash of (k, s, i),
+ * so that:
+ *  - each (seed, stream) pair yields a reproducible, independent sequence
+ *    (e.g., one stream per tree or per thread);
+ *  - jumping ahead by any number of draws is O(1) (see discard).
+ * Satisfies UniformRandomBitGenerator, so it can be used with <random> distributions.
+ */
+class CounterRNG {
+   public:
+    typedef std::uint64_t result_type;
+
+    CounterRNG(std::uint64_t seed, std::uint64_t stream = 0);
+
+    static constexpr result_type min() { return 0; }
+
+    static constexpr result_type max() { return UINT64_MAX; }
+
+    result_type operator()();
+
+    /**
+     * @brief Skip the next n draws in O(1)
+     */
+    void discard(std::uint64_t n);
+
+    /**
+     * @brief Unbiased integer in [0, range)
+     * Uses Lemire's multiply-and-reject method instead of a biased modulo
+     * @param range upper bound (exclusive), > 0
+     */
+    std::uint32_t bounded(std::uint32_t range);
+
+   private:
+    std::uint64_t key;
+    std::uint64_t counter;
+};
+
+#endif  // RANDOM_HPP
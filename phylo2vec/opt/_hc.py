@@ -7,6 +7,7 @@ import numpy as np
 
 from joblib import delayed, effective_n_jobs, Parallel
 
+from phylo2vec.datasets import read_fasta
 from phylo2vec.opt._base import BaseOptimizer
 from phylo2vec.opt._hc_losses import raxml_loss
 from phylo2vec.utils.vector import reorder_v, reroot_at_random
@@ -41,8 +42,21 @@ class HillClimbingOptimizer(BaseOptimizer):
         The number of jobs to run in parallel, by default None
     verbose : bool, optional
         Controls the verbosity when optimising, by default False
+    loss : str, optional
+        Loss to minimise, by default "raxml"
+        "raxml": negative log-likelihood from RAxML-nG
+        "bme": balanced minimum evolution on p-distances between the sequences
+        "parsimony": Fitch parsimony score
+        "bme" and "parsimony" are evaluated in-process by the C++ extension
+    native_module : module, optional
+        Compiled C++ extension (also named phylo2vec) used for the "bme" and "parsimony"
+        losses, by default None
+        It runs the whole optimisation natively, evaluating the proposals
+        of each index of v on n_jobs threads
     """
 
+    NATIVE_LOSSES = ("bme", "parsimony")
+
     def __init__(
         self,
         raxml_cmd="raxml-ng",
@@ -55,6 +69,8 @@ class HillClimbingOptimizer(BaseOptimizer):
         rounds=1,
         n_jobs=None,
         verbose=False,
+        loss="raxml",
+        native_module=None,
     ):
         super().__init__(random_seed=random_seed)
 
@@ -71,8 +87,20 @@ class HillClimbingOptimizer(BaseOptimizer):
         self.patience = patience
         self.n_jobs = effective_n_jobs(n_jobs)
         self.verbose = verbose
+        self.loss = loss
+        self.native_module = native_module
+
+        if loss != "raxml" and loss not in self.NATIVE_LOSSES:
+            raise ValueError(
+                f"Unknown loss: {loss}. Choose from: raxml, {', '.join(self.NATIVE_LOSSES)}"
+            )
+        if loss in self.NATIVE_LOSSES and native_module is None:
+            raise ValueError(f"Loss {loss} requires the compiled native_module")
 
     def _optimise(self, fasta_path, v, taxa_dict):
+        if self.loss in self.NATIVE_LOSSES:
+            return self._optimise_native(fasta_path, v, taxa_dict)
+
         current_loss = raxml_loss(
             v=v,
             taxa_dict=taxa_dict,
@@ -113,6 +141,38 @@ class HillClimbingOptimizer(BaseOptimizer):
 
         return v, taxa_dict, losses
 
+    def _optimise_native(self, fasta_path, v, taxa_dict):
+        sequences = [str(r.seq) for r in read_fasta(fasta_path)]
+
+        if self.loss == "bme":
+            loss = self.native_module.bme_loss(
+                p_distances(sequences).ravel(), len(sequences)
+            )
+        else:
+            loss = self.native_module.parsimony_loss(sequences)
+
+        def progress(p):
+            print(f"Pass {p.pass_}, index {p.index}: {p.loss:.3f} ({p.seconds:.1f}s)")
+
+        v_opt, taxa, losses = self.native_module.hill_climbing(
+            v,
+            loss,
+            reorder_method=self.reorder_method,
+            tol=self.tol,
+            patience=self.patience,
+            rounds=self.rounds,
+            n_threads=self.n_jobs,
+            seed=self.random_seed,
+            progress=progress if self.verbose else None,
+        )
+
+        # taxa[leaf] is the record (initial leaf) now at each leaf
+        new_taxa_dict = taxa_dict.copy()
+        for leaf, record in enumerate(taxa):
+            new_taxa_dict[leaf] = taxa_dict[record]
+
+        return np.array(v_opt), new_taxa_dict, losses
+
     def _optimise_single(self, fasta_path, v, taxa_dict):
         # Reorder v
         v_shuffled, taxa_dict = reorder_v(self.reorder_method, v, taxa_dict)
@@ -223,3 +283,25 @@ class HillClimbingOptimizer(BaseOptimizer):
         proposal_losses_diff = current_loss - proposal_losses
 
         return proposal_losses_diff, proposal_losses
+
+
+def p_distances(sequences):
+    """Proportion of differing sites between all pairs of aligned sequences
+
+    Parameters
+    ----------
+    sequences : list[str]
+        Aligned sequences
+
+    Returns
+    -------
+    numpy.ndarray
+        Distance matrix, shape (n, n)
+    """
+    seqs = np.array([np.frombuffer(s.upper().encode(), dtype=np.uint8) for s in sequences])
+
+    dm = np.zeros((len(seqs), len(seqs)))
+    for i in range(len(seqs)):
+        dm[i] = (seqs != seqs[i]).mean(axis=1)
+
+    return dm